@@ -0,0 +1,212 @@
+// binned_efficiency.cc
+
+// Ourselves:
+#include <binned_efficiency.h>
+
+// Standard library:
+#include <cmath>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+// Third party:
+// - GSL:
+#include <gsl/gsl_cdf.h>
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+// This project:
+#include <run_state.h>
+
+namespace analysis {
+
+  binned_efficiency::interval_type binned_efficiency::wilson_interval(uint64_t passed_, uint64_t total_,
+                                                                      double confidence_level_)
+  {
+    interval_type an_interval = {0.0, 1.0};
+    if (total_ == 0) return an_interval;
+    const double z = gsl_cdf_ugaussian_Pinv(0.5 * (1.0 + confidence_level_));
+    const double n = total_;
+    const double p = passed_ / n;
+    const double z2n = z * z / n;
+    const double centre = (p + 0.5 * z2n) / (1.0 + z2n);
+    const double half_width = z * std::sqrt(p * (1.0 - p) / n + 0.25 * z2n / n) / (1.0 + z2n);
+    an_interval.low = std::max(0.0, centre - half_width);
+    an_interval.high = std::min(1.0, centre + half_width);
+    return an_interval;
+  }
+
+  binned_efficiency::interval_type binned_efficiency::clopper_pearson_interval(uint64_t passed_, uint64_t total_,
+                                                                               double confidence_level_)
+  {
+    interval_type an_interval = {0.0, 1.0};
+    if (total_ == 0) return an_interval;
+    const double alpha = 1.0 - confidence_level_;
+    const double k = passed_;
+    const double n = total_;
+    if (passed_ > 0) an_interval.low = gsl_cdf_beta_Pinv(0.5 * alpha, k, n - k + 1);
+    if (passed_ < total_) an_interval.high = gsl_cdf_beta_Pinv(1.0 - 0.5 * alpha, k + 1, n - k);
+    return an_interval;
+  }
+
+  binned_efficiency::binned_efficiency()
+  {
+    _nbins_ = 0;
+    _min_ = 0.0;
+    _max_ = 0.0;
+    _scale_ = 0.0;
+    return;
+  }
+
+  bool binned_efficiency::is_initialized() const
+  {
+    return _nbins_ > 0;
+  }
+
+  void binned_efficiency::initialize(size_t nbins_, double min_, double max_)
+  {
+    DT_THROW_IF(nbins_ == 0, std::domain_error, "Invalid number of bins !");
+    DT_THROW_IF(! (max_ > min_), std::domain_error, "Invalid range [" << min_ << ", " << max_ << ") !");
+    _nbins_ = nbins_;
+    _min_ = min_;
+    _max_ = max_;
+    _scale_ = nbins_ / (max_ - min_);
+    _passed_.assign(nbins_ + 2, 0);
+    _total_.assign(nbins_ + 2, 0);
+    return;
+  }
+
+  void binned_efficiency::reset()
+  {
+    _nbins_ = 0;
+    _min_ = 0.0;
+    _max_ = 0.0;
+    _scale_ = 0.0;
+    _passed_.clear();
+    _total_.clear();
+    return;
+  }
+
+  size_t binned_efficiency::get_number_of_bins() const
+  {
+    return _nbins_;
+  }
+
+  double binned_efficiency::get_min() const
+  {
+    return _min_;
+  }
+
+  double binned_efficiency::get_max() const
+  {
+    return _max_;
+  }
+
+  size_t binned_efficiency::get_bin(double value_) const
+  {
+    if (! (value_ >= _min_)) return 0;
+    if (value_ >= _max_) return _nbins_ + 1;
+    // Rounding may push values just below the upper edge out of range
+    return std::min<size_t>(1 + static_cast<size_t>((value_ - _min_) * _scale_), _nbins_);
+  }
+
+  double binned_efficiency::get_bin_low(size_t bin_) const
+  {
+    if (bin_ == 0) return -HUGE_VAL;
+    return _min_ + (bin_ - 1) / _scale_;
+  }
+
+  double binned_efficiency::get_bin_high(size_t bin_) const
+  {
+    if (bin_ > _nbins_) return HUGE_VAL;
+    return _min_ + bin_ / _scale_;
+  }
+
+  uint64_t binned_efficiency::get_passed(size_t bin_) const
+  {
+    return _passed_[bin_];
+  }
+
+  uint64_t binned_efficiency::get_total(size_t bin_) const
+  {
+    return _total_[bin_];
+  }
+
+  void binned_efficiency::fill(double value_, bool passed_)
+  {
+    const size_t a_bin = get_bin(value_);
+    _total_[a_bin]++;
+    if (passed_) _passed_[a_bin]++;
+    return;
+  }
+
+  void binned_efficiency::merge(const binned_efficiency & other_)
+  {
+    DT_THROW_IF(other_._nbins_ != _nbins_ || other_._min_ != _min_ || other_._max_ != _max_,
+                std::logic_error, "Binnings differ !");
+    for (size_t ibin = 0; ibin < _total_.size(); ibin++) {
+      _passed_[ibin] += other_._passed_[ibin];
+      _total_[ibin] += other_._total_[ibin];
+    }
+    return;
+  }
+
+  void binned_efficiency::clear()
+  {
+    std::fill(_passed_.begin(), _passed_.end(), 0);
+    std::fill(_total_.begin(), _total_.end(), 0);
+    return;
+  }
+
+  std::string binned_efficiency::get_binning_prefix(const std::string & prefix_) const
+  {
+    std::ostringstream a_prefix;
+    a_prefix << prefix_ << _nbins_ << "bins_" << _min_ << '_' << _max_ << '.';
+    return a_prefix.str();
+  }
+
+  void binned_efficiency::export_counters(run_state & state_, const std::string & prefix_) const
+  {
+    const std::string a_binning_prefix = get_binning_prefix(prefix_);
+    for (size_t ibin = 0; ibin < _total_.size(); ibin++) {
+      std::ostringstream a_prefix;
+      a_prefix << a_binning_prefix << ibin << '.';
+      state_.set_counter(a_prefix.str() + "passed", _passed_[ibin]);
+      state_.set_counter(a_prefix.str() + "total", _total_[ibin]);
+    }
+    return;
+  }
+
+  void binned_efficiency::import_counters(const run_state & state_, const std::string & prefix_)
+  {
+    // Counts stored with another binning cannot be added bin by bin:
+    const std::string a_binning_prefix = get_binning_prefix(prefix_);
+    const run_state::counter_dict_type & the_counters = state_.get_counters();
+    for (auto icounter = the_counters.lower_bound(prefix_);
+         icounter != the_counters.end() && icounter->first.compare(0, prefix_.size(), prefix_) == 0;
+         icounter++) {
+      DT_THROW_IF(icounter->first.compare(0, a_binning_prefix.size(), a_binning_prefix) != 0,
+                  std::logic_error,
+                  "Run state counter '" << icounter->first << "' was stored with another binning than '"
+                  << a_binning_prefix << "' !");
+    }
+    for (size_t ibin = 0; ibin < _total_.size(); ibin++) {
+      std::ostringstream a_prefix;
+      a_prefix << a_binning_prefix << ibin << '.';
+      if (! state_.has_counter(a_prefix.str() + "total")) continue;
+      _passed_[ibin] += state_.get_counter(a_prefix.str() + "passed");
+      _total_[ibin] += state_.get_counter(a_prefix.str() + "total");
+    }
+    return;
+  }
+
+} // namespace analysis
+
+// end of binned_efficiency.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
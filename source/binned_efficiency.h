@@ -0,0 +1,137 @@
+/* binned_efficiency.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Efficiency binned along a variable: each bin holds the numbers of
+ * passed and total trials. Bins are uniform in [min, max), with an
+ * underflow and an overflow bin, and are allocated once so that filling
+ * is a constant time operation. Binomial confidence intervals are given
+ * with the Wilson score and the Clopper-Pearson methods.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_BINNED_EFFICIENCY_H_
+#define ANALYSIS_BINNED_EFFICIENCY_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace analysis {
+
+  class run_state;
+
+  class binned_efficiency
+  {
+  public:
+
+    /// Confidence interval
+    struct interval_type {
+      double low;  //!< Lower bound
+      double high; //!< Upper bound
+    };
+
+    /// Wilson score interval of 'passed_' successes out of 'total_' trials
+    static interval_type wilson_interval(uint64_t passed_, uint64_t total_, double confidence_level_);
+
+    /// Clopper-Pearson (exact) interval of 'passed_' successes out of 'total_' trials
+    static interval_type clopper_pearson_interval(uint64_t passed_, uint64_t total_, double confidence_level_);
+
+    /// Constructor
+    binned_efficiency();
+
+    /// Check initialization flag
+    bool is_initialized() const;
+
+    /// Allocate 'nbins_' uniform bins in [min_, max_) plus underflow and overflow bins
+    void initialize(size_t nbins_, double min_, double max_);
+
+    /// Reset
+    void reset();
+
+    /// Return the number of bins in range
+    size_t get_number_of_bins() const;
+
+    /// Return the lower edge of the range
+    double get_min() const;
+
+    /// Return the upper edge of the range
+    double get_max() const;
+
+    /// Return the index of the bin holding a value (0: underflow, number of bins + 1: overflow)
+    size_t get_bin(double value_) const;
+
+    /// Return the lower edge of a bin
+    double get_bin_low(size_t bin_) const;
+
+    /// Return the upper edge of a bin
+    double get_bin_high(size_t bin_) const;
+
+    /// Return the number of passed trials of a bin
+    uint64_t get_passed(size_t bin_) const;
+
+    /// Return the number of trials of a bin
+    uint64_t get_total(size_t bin_) const;
+
+    /// Account for a trial
+    void fill(double value_, bool passed_);
+
+    /// Add the counts of an efficiency with the same binning
+    void merge(const binned_efficiency & other_);
+
+    /// Zero the counts
+    void clear();
+
+    /// Return the prefix of the run state counters: 'prefix_' followed by the binning
+    std::string get_binning_prefix(const std::string & prefix_) const;
+
+    /// Store the counts in a run state, under the binning prefix
+    void export_counters(run_state & state_, const std::string & prefix_) const;
+
+    /// Add the counts found in a run state, reject counts stored with another binning
+    void import_counters(const run_state & state_, const std::string & prefix_);
+
+  private:
+
+    size_t _nbins_;  //!< Number of bins in range
+    double _min_;    //!< Lower edge of the range
+    double _max_;    //!< Upper edge of the range
+    double _scale_;  //!< Number of bins per unit
+    std::vector<uint64_t> _passed_; //!< Passed trials per bin
+    std::vector<uint64_t> _total_;  //!< Trials per bin
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_BINNED_EFFICIENCY_H_
+
+// end of binned_efficiency.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
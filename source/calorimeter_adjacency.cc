@@ -0,0 +1,152 @@
+// calorimeter_adjacency.cc
+
+// Ourselves:
+#include <calorimeter_adjacency.h>
+
+// Standard library:
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+// - Falaise
+#include <snemo/geometry/locator_plugin.h>
+#include <snemo/geometry/calo_locator.h>
+#include <snemo/geometry/xcalo_locator.h>
+#include <snemo/geometry/gveto_locator.h>
+
+namespace analysis {
+
+  bool calorimeter_adjacency::is_calorimeter_block(const snemo::geometry::locator_plugin & locator_,
+                                                   const geomtools::geom_id & gid_)
+  {
+    return locator_.get_calo_locator().is_calo_block_in_current_module(gid_)
+      || locator_.get_xcalo_locator().is_calo_block_in_current_module(gid_)
+      || locator_.get_gveto_locator().is_calo_block_in_current_module(gid_);
+  }
+
+  // Collect first neighbours the same way the module used to do it on the
+  // fly i.e. by asking every locator owning the block
+  void calorimeter_adjacency::fetch_neighbours(const snemo::geometry::locator_plugin & locator_,
+                                               const geomtools::geom_id & gid_,
+                                               std::vector<geomtools::geom_id> & neighbours_)
+  {
+    const snemo::geometry::calo_locator & calo_locator
+      = locator_.get_calo_locator();
+    const snemo::geometry::xcalo_locator & xcalo_locator
+      = locator_.get_xcalo_locator();
+    const snemo::geometry::gveto_locator & gveto_locator
+      = locator_.get_gveto_locator();
+
+    if (calo_locator.is_calo_block_in_current_module(gid_))
+      calo_locator.get_neighbours_ids(gid_, neighbours_, snemo::geometry::utils::NEIGHBOUR_FIRST);
+
+    if (xcalo_locator.is_calo_block_in_current_module(gid_))
+      xcalo_locator.get_neighbours_ids(gid_, neighbours_, snemo::geometry::utils::NEIGHBOUR_FIRST);
+
+    if (gveto_locator.is_calo_block_in_current_module(gid_))
+      gveto_locator.get_neighbours_ids(gid_, neighbours_, snemo::geometry::utils::NEIGHBOUR_FIRST);
+    return;
+  }
+
+  calorimeter_adjacency::calorimeter_adjacency()
+  {
+    _initialized_ = false;
+    return;
+  }
+
+  bool calorimeter_adjacency::is_initialized() const
+  {
+    return _initialized_;
+  }
+
+  void calorimeter_adjacency::initialize(const calorimeter_channel_index & channels_,
+                                         const snemo::geometry::locator_plugin & locator_)
+  {
+    DT_THROW_IF(is_initialized(), std::logic_error, "Adjacency table is already initialized !");
+    DT_THROW_IF(! channels_.is_initialized(), std::logic_error, "Channel index is not initialized !");
+
+    std::vector<geomtools::geom_id> the_neighbours;
+    _offsets_.reserve(channels_.size() + 1);
+    _offsets_.push_back(0);
+    for (const auto & igid : channels_.get_geom_ids()) {
+      the_neighbours.clear();
+      fetch_neighbours(locator_, igid, the_neighbours);
+      for (const auto & ineighbour : the_neighbours) {
+        const channel_type a_channel = channels_.get_channel(ineighbour);
+        DT_THROW_IF(a_channel == calorimeter_channel_index::INVALID_CHANNEL, std::logic_error,
+                    "Calorimeter " << ineighbour << " has no channel !");
+        _neighbours_.push_back(a_channel);
+      }
+      _offsets_.push_back(_neighbours_.size());
+    }
+
+    _initialized_ = true;
+    return;
+  }
+
+  void calorimeter_adjacency::initialize(const std::vector<uint32_t> & offsets_,
+                                         const std::vector<channel_type> & neighbours_)
+  {
+    DT_THROW_IF(is_initialized(), std::logic_error, "Adjacency table is already initialized !");
+    DT_THROW_IF(offsets_.empty() || offsets_.front() != 0 || offsets_.back() != neighbours_.size(),
+                std::logic_error, "Invalid adjacency row offsets !");
+    const size_t nchannels = offsets_.size() - 1;
+    for (size_t i = 0; i < nchannels; i++) {
+      DT_THROW_IF(offsets_[i] > offsets_[i + 1], std::logic_error, "Invalid adjacency row offsets !");
+    }
+    for (const auto ineighbour : neighbours_) {
+      DT_THROW_IF(ineighbour >= nchannels, std::logic_error, "Invalid neighbour channel " << ineighbour << " !");
+    }
+    _offsets_ = offsets_;
+    _neighbours_ = neighbours_;
+    _initialized_ = true;
+    return;
+  }
+
+  void calorimeter_adjacency::reset()
+  {
+    _offsets_.clear();
+    _neighbours_.clear();
+    _initialized_ = false;
+    return;
+  }
+
+  size_t calorimeter_adjacency::get_number_of_channels() const
+  {
+    return _offsets_.empty() ? 0 : _offsets_.size() - 1;
+  }
+
+  const calorimeter_adjacency::channel_type *
+  calorimeter_adjacency::neighbours_begin(channel_type channel_) const
+  {
+    return _neighbours_.data() + _offsets_[channel_];
+  }
+
+  const calorimeter_adjacency::channel_type *
+  calorimeter_adjacency::neighbours_end(channel_type channel_) const
+  {
+    return _neighbours_.data() + _offsets_[channel_ + 1];
+  }
+
+  const std::vector<uint32_t> & calorimeter_adjacency::get_offsets() const
+  {
+    return _offsets_;
+  }
+
+  const std::vector<calorimeter_adjacency::channel_type> & calorimeter_adjacency::get_neighbours() const
+  {
+    return _neighbours_;
+  }
+
+} // namespace analysis
+
+// end of calorimeter_adjacency.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
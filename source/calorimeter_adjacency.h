@@ -0,0 +1,120 @@
+/* calorimeter_adjacency.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Table of first neighbours for every calorimeter (main wall, X-wall and
+ * gamma veto) block of the current module. The table is filled once from the
+ * locator plugin and stored in a compressed sparse row layout indexed by the
+ * dense channel number of the calorimeter channel index.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_CALORIMETER_ADJACENCY_H_
+#define ANALYSIS_CALORIMETER_ADJACENCY_H_ 1
+
+// Standard libraries:
+#include <vector>
+#include <cstdint>
+// Third party:
+// - Bayeux/geomtools:
+#include <geomtools/geom_id.h>
+
+// This project:
+#include <calorimeter_channel_index.h>
+
+namespace snemo {
+  namespace geometry {
+    class locator_plugin;
+  }
+}
+
+namespace analysis {
+
+  class calorimeter_adjacency
+  {
+  public:
+
+    /// Typedef for dense channel number
+    typedef calorimeter_channel_index::channel_type channel_type;
+
+    /// Check if a geometry id is a calorimeter block of the current module
+    static bool is_calorimeter_block(const snemo::geometry::locator_plugin & locator_,
+                                     const geomtools::geom_id & gid_);
+
+    /// Append the first neighbours of a calorimeter block given by the locators
+    static void fetch_neighbours(const snemo::geometry::locator_plugin & locator_,
+                                 const geomtools::geom_id & gid_,
+                                 std::vector<geomtools::geom_id> & neighbours_);
+
+    /// Constructor
+    calorimeter_adjacency();
+
+    /// Check initialization flag
+    bool is_initialized() const;
+
+    /// Build the table from the locator plugin
+    void initialize(const calorimeter_channel_index & channels_,
+                    const snemo::geometry::locator_plugin & locator_);
+
+    /// Build the table from CSR row offsets and neighbour channels
+    void initialize(const std::vector<uint32_t> & offsets_,
+                    const std::vector<channel_type> & neighbours_);
+
+    /// Reset
+    void reset();
+
+    /// Return the number of channels
+    size_t get_number_of_channels() const;
+
+    /// Return the first neighbour of a channel
+    const channel_type * neighbours_begin(channel_type channel_) const;
+
+    /// Return the past-the-end neighbour of a channel
+    const channel_type * neighbours_end(channel_type channel_) const;
+
+    /// Return the CSR row offsets
+    const std::vector<uint32_t> & get_offsets() const;
+
+    /// Return the CSR neighbour channels
+    const std::vector<channel_type> & get_neighbours() const;
+
+  private:
+
+    bool _initialized_; //!< Initialization flag
+
+    std::vector<uint32_t> _offsets_;        //!< CSR row offsets (size = number of channels + 1)
+    std::vector<channel_type> _neighbours_; //!< CSR neighbour channels
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_CALORIMETER_ADJACENCY_H_
+
+// end of calorimeter_adjacency.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,166 @@
+// calorimeter_bitset.cc
+
+// Ourselves:
+#include <calorimeter_bitset.h>
+
+// Standard library:
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+namespace analysis {
+
+  const size_t calorimeter_bitset::CAPACITY;
+  const size_t calorimeter_bitset::NUMBER_OF_WORDS;
+
+  calorimeter_bitset::const_iterator::const_iterator(const word_type * words_, size_t iword_)
+  {
+    _words_ = words_;
+    _iword_ = iword_;
+    _current_ = _iword_ < NUMBER_OF_WORDS ? _words_[_iword_] : 0;
+    _seek_();
+    return;
+  }
+
+  void calorimeter_bitset::const_iterator::_seek_()
+  {
+    while (_current_ == 0 && _iword_ < NUMBER_OF_WORDS) {
+      _iword_++;
+      if (_iword_ < NUMBER_OF_WORDS) _current_ = _words_[_iword_];
+    }
+    return;
+  }
+
+  calorimeter_bitset::channel_type calorimeter_bitset::const_iterator::operator*() const
+  {
+    return _iword_ * 64 + __builtin_ctzll(_current_);
+  }
+
+  calorimeter_bitset::const_iterator & calorimeter_bitset::const_iterator::operator++()
+  {
+    // Drop the lowest bit set
+    _current_ &= _current_ - 1;
+    _seek_();
+    return *this;
+  }
+
+  calorimeter_bitset::const_iterator calorimeter_bitset::const_iterator::operator++(int)
+  {
+    const_iterator a_copy = *this;
+    ++(*this);
+    return a_copy;
+  }
+
+  bool calorimeter_bitset::const_iterator::operator==(const const_iterator & other_) const
+  {
+    return _iword_ == other_._iword_ && _current_ == other_._current_;
+  }
+
+  bool calorimeter_bitset::const_iterator::operator!=(const const_iterator & other_) const
+  {
+    return ! (*this == other_);
+  }
+
+  calorimeter_bitset::calorimeter_bitset()
+  {
+    clear();
+    return;
+  }
+
+  bool calorimeter_bitset::insert(channel_type channel_)
+  {
+    DT_THROW_IF(channel_ >= CAPACITY, std::range_error,
+                "Calorimeter channel " << channel_ << " exceeds bitset capacity (" << CAPACITY << ") !");
+    const word_type a_bit = word_type(1) << (channel_ % 64);
+    word_type & a_word = _words_[channel_ / 64];
+    if (a_word & a_bit) return false;
+    a_word |= a_bit;
+    _size_++;
+    return true;
+  }
+
+  bool calorimeter_bitset::has(channel_type channel_) const
+  {
+    if (channel_ >= CAPACITY) return false;
+    return _words_[channel_ / 64] & (word_type(1) << (channel_ % 64));
+  }
+
+  size_t calorimeter_bitset::size() const
+  {
+    return _size_;
+  }
+
+  bool calorimeter_bitset::empty() const
+  {
+    return _size_ == 0;
+  }
+
+  void calorimeter_bitset::clear()
+  {
+    _size_ = 0;
+    for (size_t i = 0; i < NUMBER_OF_WORDS; i++) _words_[i] = 0;
+    return;
+  }
+
+  size_t calorimeter_bitset::count_common(const calorimeter_bitset & other_) const
+  {
+    size_t a_count = 0;
+    for (size_t i = 0; i < NUMBER_OF_WORDS; i++) {
+      a_count += __builtin_popcountll(_words_[i] & other_._words_[i]);
+    }
+    return a_count;
+  }
+
+  size_t calorimeter_bitset::count_difference(const calorimeter_bitset & other_) const
+  {
+    return _size_ - count_common(other_);
+  }
+
+  bool calorimeter_bitset::intersects(const calorimeter_bitset & other_) const
+  {
+    word_type a_common = 0;
+    for (size_t i = 0; i < NUMBER_OF_WORDS; i++) a_common |= _words_[i] & other_._words_[i];
+    return a_common != 0;
+  }
+
+  const calorimeter_bitset::word_type * calorimeter_bitset::get_words() const
+  {
+    return _words_;
+  }
+
+  calorimeter_bitset::const_iterator calorimeter_bitset::begin() const
+  {
+    return const_iterator(_words_, 0);
+  }
+
+  calorimeter_bitset::const_iterator calorimeter_bitset::end() const
+  {
+    return const_iterator(_words_, NUMBER_OF_WORDS);
+  }
+
+  bool calorimeter_bitset::operator==(const calorimeter_bitset & other_) const
+  {
+    if (_size_ != other_._size_) return false;
+    // No early exit so that the loop is vectorized
+    word_type a_difference = 0;
+    for (size_t i = 0; i < NUMBER_OF_WORDS; i++) a_difference |= _words_[i] ^ other_._words_[i];
+    return a_difference == 0;
+  }
+
+  bool calorimeter_bitset::operator!=(const calorimeter_bitset & other_) const
+  {
+    return ! (*this == other_);
+  }
+
+} // namespace analysis
+
+// end of calorimeter_bitset.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
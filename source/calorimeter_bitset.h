@@ -0,0 +1,162 @@
+/* calorimeter_bitset.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Fixed size set of calorimeter channels stored as a bitset. It offers the
+ * subset of the std::set interface used by the gamma tracking efficiency
+ * module (insert, size, ordered iteration, equality) so that it can be used
+ * as calorimeter list. Comparisons are done word by word without any
+ * allocation.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_CALORIMETER_BITSET_H_
+#define ANALYSIS_CALORIMETER_BITSET_H_ 1
+
+// Standard libraries:
+#include <iterator>
+#include <cstdint>
+#include <cstddef>
+
+namespace analysis {
+
+  class calorimeter_bitset
+  {
+  public:
+
+    /// Typedef for dense channel number
+    typedef uint16_t channel_type;
+
+    /// Typedef for set elements
+    typedef channel_type value_type;
+
+    /// Typedef for storage word
+    typedef uint64_t word_type;
+
+    /// Maximum number of channels
+    static const size_t CAPACITY = 1024;
+
+    /// Number of storage words
+    static const size_t NUMBER_OF_WORDS = CAPACITY / 64;
+
+    /// Iterator over the channels, in increasing order
+    class const_iterator
+    {
+    public:
+
+      typedef std::forward_iterator_tag iterator_category;
+      typedef channel_type value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef const channel_type * pointer;
+      typedef channel_type reference;
+
+      /// Constructor
+      const_iterator(const word_type * words_, size_t iword_);
+
+      /// Return the current channel
+      channel_type operator*() const;
+
+      /// Move to the next channel
+      const_iterator & operator++();
+
+      /// Move to the next channel
+      const_iterator operator++(int);
+
+      /// Equality
+      bool operator==(const const_iterator & other_) const;
+
+      /// Inequality
+      bool operator!=(const const_iterator & other_) const;
+
+    private:
+
+      /// Skip empty words
+      void _seek_();
+
+      const word_type * _words_; //!< Storage words
+      size_t _iword_;            //!< Current word index
+      word_type _current_;       //!< Remaining bits of the current word
+    };
+
+    typedef const_iterator iterator;
+
+    /// Constructor
+    calorimeter_bitset();
+
+    /// Insert a channel, return true if it was not already in the set
+    bool insert(channel_type channel_);
+
+    /// Check if a channel is in the set
+    bool has(channel_type channel_) const;
+
+    /// Return the number of channels
+    size_t size() const;
+
+    /// Check if the set is empty
+    bool empty() const;
+
+    /// Remove all channels
+    void clear();
+
+    /// Return the number of channels shared with another set
+    size_t count_common(const calorimeter_bitset & other_) const;
+
+    /// Return the number of channels not in another set
+    size_t count_difference(const calorimeter_bitset & other_) const;
+
+    /// Check if some channels are shared with another set
+    bool intersects(const calorimeter_bitset & other_) const;
+
+    /// Return the storage words
+    const word_type * get_words() const;
+
+    /// Return the first channel
+    const_iterator begin() const;
+
+    /// Return the past-the-end channel
+    const_iterator end() const;
+
+    /// Equality
+    bool operator==(const calorimeter_bitset & other_) const;
+
+    /// Inequality
+    bool operator!=(const calorimeter_bitset & other_) const;
+
+  private:
+
+    uint32_t _size_;                       //!< Number of channels
+    word_type _words_[NUMBER_OF_WORDS];    //!< Storage words
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_CALORIMETER_BITSET_H_
+
+// end of calorimeter_bitset.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,160 @@
+// calorimeter_channel_index.cc
+
+// Ourselves:
+#include <calorimeter_channel_index.h>
+
+// Standard library:
+#include <set>
+#include <algorithm>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+// - Bayeux/geomtools:
+#include <geomtools/manager.h>
+#include <geomtools/mapping.h>
+
+// - Falaise
+#include <snemo/geometry/locator_plugin.h>
+#include <snemo/geometry/calo_locator.h>
+#include <snemo/geometry/xcalo_locator.h>
+#include <snemo/geometry/gveto_locator.h>
+
+// This project:
+#include <calorimeter_adjacency.h>
+
+namespace analysis {
+
+  const calorimeter_channel_index::channel_type calorimeter_channel_index::INVALID_CHANNEL;
+
+  calorimeter_channel_index::calorimeter_channel_index()
+  {
+    _initialized_ = false;
+    _mask_ = 0;
+    return;
+  }
+
+  bool calorimeter_channel_index::is_initialized() const
+  {
+    return _initialized_;
+  }
+
+  void calorimeter_channel_index::initialize(const geomtools::manager & geo_mgr_,
+                                             const snemo::geometry::locator_plugin & locator_)
+  {
+    // Seed the list of blocks with the ones known by the geometry mapping and
+    // complete it with the neighbour ids returned by the locators: these are
+    // the ids the locators build themselves and may differ from the mapping
+    // ones (e.g. wildcarded block part).
+    std::set<geomtools::geom_id> the_blocks;
+    std::vector<geomtools::geom_id> the_pending;
+    const geomtools::geom_info_dict_type & the_infos = geo_mgr_.get_mapping().get_geom_infos();
+    for (const auto & iinfo : the_infos) {
+      const geomtools::geom_id & gid = iinfo.first;
+      if (! calorimeter_adjacency::is_calorimeter_block(locator_, gid)) continue;
+      if (the_blocks.insert(gid).second) the_pending.push_back(gid);
+    }
+
+    std::vector<geomtools::geom_id> the_neighbours;
+    while (! the_pending.empty()) {
+      const geomtools::geom_id gid = the_pending.back();
+      the_pending.pop_back();
+      the_neighbours.clear();
+      calorimeter_adjacency::fetch_neighbours(locator_, gid, the_neighbours);
+      for (const auto & ineighbour : the_neighbours) {
+        if (the_blocks.insert(ineighbour).second) the_pending.push_back(ineighbour);
+      }
+    }
+    DT_THROW_IF(the_blocks.empty(), std::logic_error, "No calorimeter block found in the current module !");
+
+    initialize(std::vector<geomtools::geom_id>(the_blocks.begin(), the_blocks.end()));
+    return;
+  }
+
+  void calorimeter_channel_index::initialize(const std::vector<geomtools::geom_id> & gids_)
+  {
+    DT_THROW_IF(is_initialized(), std::logic_error, "Channel index is already initialized !");
+    DT_THROW_IF(gids_.size() >= INVALID_CHANNEL, std::range_error,
+                "Too many calorimeter channels (" << gids_.size() << ") !");
+    DT_THROW_IF(! std::is_sorted(gids_.begin(), gids_.end()), std::logic_error,
+                "Calorimeter channels must follow geom_id ordering !");
+
+    _channels_ = gids_;
+
+    // Keep the table at most one quarter full
+    uint32_t a_size = 16;
+    while (a_size < 4 * _channels_.size()) a_size <<= 1;
+    _mask_ = a_size - 1;
+    _table_.assign(a_size, INVALID_CHANNEL);
+    for (channel_type ich = 0; ich < _channels_.size(); ich++) {
+      uint32_t a_slot = _hash_(_channels_[ich]) & _mask_;
+      while (_table_[a_slot] != INVALID_CHANNEL) {
+        DT_THROW_IF(_channels_[_table_[a_slot]] == _channels_[ich], std::logic_error,
+                    "Calorimeter channel " << _channels_[ich] << " is duplicated !");
+        a_slot = (a_slot + 1) & _mask_;
+      }
+      _table_[a_slot] = ich;
+    }
+
+    _initialized_ = true;
+    return;
+  }
+
+  void calorimeter_channel_index::reset()
+  {
+    _channels_.clear();
+    _table_.clear();
+    _mask_ = 0;
+    _initialized_ = false;
+    return;
+  }
+
+  size_t calorimeter_channel_index::size() const
+  {
+    return _channels_.size();
+  }
+
+  calorimeter_channel_index::channel_type
+  calorimeter_channel_index::get_channel(const geomtools::geom_id & gid_) const
+  {
+    if (_table_.empty()) return INVALID_CHANNEL;
+    uint32_t a_slot = _hash_(gid_) & _mask_;
+    while (_table_[a_slot] != INVALID_CHANNEL) {
+      if (_channels_[_table_[a_slot]] == gid_) return _table_[a_slot];
+      a_slot = (a_slot + 1) & _mask_;
+    }
+    return INVALID_CHANNEL;
+  }
+
+  const geomtools::geom_id & calorimeter_channel_index::get_geom_id(channel_type channel_) const
+  {
+    return _channels_[channel_];
+  }
+
+  const std::vector<geomtools::geom_id> & calorimeter_channel_index::get_geom_ids() const
+  {
+    return _channels_;
+  }
+
+  uint32_t calorimeter_channel_index::_hash_(const geomtools::geom_id & gid_)
+  {
+    // FNV-1a over type and addresses
+    uint32_t a_hash = 2166136261u;
+    a_hash = (a_hash ^ gid_.get_type()) * 16777619u;
+    for (size_t i = 0; i < gid_.get_depth(); i++) {
+      a_hash = (a_hash ^ gid_.get(i)) * 16777619u;
+    }
+    return a_hash ^ (a_hash >> 15);
+  }
+
+} // namespace analysis
+
+// end of calorimeter_channel_index.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,118 @@
+/* calorimeter_channel_index.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Dense numbering of the calorimeter (main wall, X-wall and gamma veto)
+ * blocks of the current module. Channels follow the geom_id ordering so
+ * that sorting channels is equivalent to sorting geometry ids. The
+ * geom_id to channel conversion goes through an open addressing hash
+ * table stored in a flat array.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_CALORIMETER_CHANNEL_INDEX_H_
+#define ANALYSIS_CALORIMETER_CHANNEL_INDEX_H_ 1
+
+// Standard libraries:
+#include <vector>
+#include <cstdint>
+// Third party:
+// - Bayeux/geomtools:
+#include <geomtools/geom_id.h>
+
+namespace geomtools {
+  class manager;
+}
+
+namespace snemo {
+  namespace geometry {
+    class locator_plugin;
+  }
+}
+
+namespace analysis {
+
+  class calorimeter_channel_index
+  {
+  public:
+
+    /// Typedef for dense channel number
+    typedef uint16_t channel_type;
+
+    /// Invalid channel number
+    static const channel_type INVALID_CHANNEL = 0xFFFF;
+
+    /// Constructor
+    calorimeter_channel_index();
+
+    /// Check initialization flag
+    bool is_initialized() const;
+
+    /// Enumerate calorimeter blocks from the geometry mapping and the locator plugin
+    void initialize(const geomtools::manager & geo_mgr_,
+                    const snemo::geometry::locator_plugin & locator_);
+
+    /// Number channels from a list of geometry ids
+    void initialize(const std::vector<geomtools::geom_id> & gids_);
+
+    /// Reset
+    void reset();
+
+    /// Return the number of channels
+    size_t size() const;
+
+    /// Return the channel number of a calorimeter block (INVALID_CHANNEL if unknown)
+    channel_type get_channel(const geomtools::geom_id & gid_) const;
+
+    /// Return the geometry id of a channel
+    const geomtools::geom_id & get_geom_id(channel_type channel_) const;
+
+    /// Return the geometry ids of all channels
+    const std::vector<geomtools::geom_id> & get_geom_ids() const;
+
+  private:
+
+    /// Hash a geometry id
+    static uint32_t _hash_(const geomtools::geom_id & gid_);
+
+  private:
+
+    bool _initialized_; //!< Initialization flag
+
+    std::vector<geomtools::geom_id> _channels_; //!< Geometry id per channel
+    std::vector<channel_type> _table_;          //!< Open addressing table of channels
+    uint32_t _mask_;                            //!< Table size - 1
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_CALORIMETER_CHANNEL_INDEX_H_
+
+// end of calorimeter_channel_index.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
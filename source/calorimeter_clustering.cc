@@ -0,0 +1,120 @@
+// calorimeter_clustering.cc
+
+// Ourselves:
+#include <calorimeter_clustering.h>
+
+namespace analysis {
+
+  calorimeter_clustering::calorimeter_clustering()
+  {
+    _transitive_ = false;
+    _nchannels_ = 0;
+    _offsets_ = 0;
+    _neighbours_ = 0;
+    return;
+  }
+
+  void calorimeter_clustering::set_neighbourhood(size_t nchannels_,
+                                                 const uint32_t * offsets_,
+                                                 const channel_type * neighbours_)
+  {
+    _nchannels_ = nchannels_;
+    _offsets_ = offsets_;
+    _neighbours_ = neighbours_;
+    _hit_slots_.assign(_nchannels_, -1);
+    _used_.assign(_nchannels_, 0);
+    return;
+  }
+
+  bool calorimeter_clustering::is_transitive() const
+  {
+    return _transitive_;
+  }
+
+  void calorimeter_clustering::set_transitive(bool transitive_)
+  {
+    _transitive_ = transitive_;
+    return;
+  }
+
+  void calorimeter_clustering::process(const channel_type * channels_, size_t nhits_)
+  {
+    _cluster_offsets_.clear();
+    _cluster_members_.clear();
+    _cluster_offsets_.push_back(0);
+
+    // Keep the first hit of each channel
+    for (size_t ihit = 0; ihit < nhits_; ihit++) {
+      const channel_type a_channel = channels_[ihit];
+      if (a_channel >= _nchannels_) continue;
+      if (_hit_slots_[a_channel] != -1) continue;
+      _hit_slots_[a_channel] = ihit;
+      _touched_.push_back(a_channel);
+    }
+
+    for (size_t ihit = 0; ihit < nhits_; ihit++) {
+      const channel_type a_channel = channels_[ihit];
+
+      // Unknown block: isolated cluster
+      if (a_channel >= _nchannels_) {
+        _cluster_members_.push_back(ihit);
+        _cluster_offsets_.push_back(_cluster_members_.size());
+        continue;
+      }
+
+      if (_used_[a_channel]) continue;
+      _used_[a_channel] = 1;
+      _cluster_members_.push_back(ihit);
+
+      _queue_.clear();
+      _queue_.push_back(a_channel);
+      for (size_t iqueue = 0; iqueue < _queue_.size(); iqueue++) {
+        const channel_type a_current = _queue_[iqueue];
+        for (uint32_t i = _offsets_[a_current]; i < _offsets_[a_current + 1]; i++) {
+          const channel_type a_neighbour = _neighbours_[i];
+          if (_hit_slots_[a_neighbour] == -1) continue;
+          if (_used_[a_neighbour]) continue;
+          _used_[a_neighbour] = 1;
+          _cluster_members_.push_back(_hit_slots_[a_neighbour]);
+          if (_transitive_) _queue_.push_back(a_neighbour);
+        }
+      }
+      _cluster_offsets_.push_back(_cluster_members_.size());
+    }
+
+    // Clean working space for next event
+    for (auto ichannel : _touched_) {
+      _hit_slots_[ichannel] = -1;
+      _used_[ichannel] = 0;
+    }
+    _touched_.clear();
+    return;
+  }
+
+  size_t calorimeter_clustering::get_number_of_clusters() const
+  {
+    return _cluster_offsets_.empty() ? 0 : _cluster_offsets_.size() - 1;
+  }
+
+  const calorimeter_clustering::hit_index_type *
+  calorimeter_clustering::cluster_begin(size_t icluster_) const
+  {
+    return _cluster_members_.data() + _cluster_offsets_[icluster_];
+  }
+
+  const calorimeter_clustering::hit_index_type *
+  calorimeter_clustering::cluster_end(size_t icluster_) const
+  {
+    return _cluster_members_.data() + _cluster_offsets_[icluster_ + 1];
+  }
+
+} // namespace analysis
+
+// end of calorimeter_clustering.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
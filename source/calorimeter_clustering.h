@@ -0,0 +1,112 @@
+/* calorimeter_clustering.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Non recursive clustering of calorimeter hits given a first neighbours
+ * table in CSR layout. Hits are referenced by their index in the input
+ * array and blocks by their dense channel number. Every membership check
+ * is done through a per-channel lookup table so the processing time is
+ * linear in the number of hits and neighbours.
+ *
+ * By default, a cluster is made of a seed hit and its first neighbours not
+ * yet used by another cluster, which is what the former recursive
+ * 'get_new_neighbours' method was actually doing. The 'transitive' mode
+ * builds real connected components.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_CALORIMETER_CLUSTERING_H_
+#define ANALYSIS_CALORIMETER_CLUSTERING_H_ 1
+
+// Standard libraries:
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace analysis {
+
+  class calorimeter_clustering
+  {
+  public:
+
+    /// Typedef for dense channel number
+    typedef uint16_t channel_type;
+
+    /// Typedef for hit index
+    typedef uint32_t hit_index_type;
+
+    /// Constructor
+    calorimeter_clustering();
+
+    /// Set the neighbours table
+    void set_neighbourhood(size_t nchannels_,
+                           const uint32_t * offsets_,
+                           const channel_type * neighbours_);
+
+    /// Check if neighbours are followed beyond the seed first neighbours
+    bool is_transitive() const;
+
+    /// Set the transitive flag
+    void set_transitive(bool transitive_);
+
+    /// Build clusters from an array of hit channels
+    void process(const channel_type * channels_, size_t nhits_);
+
+    /// Return the number of clusters found by the last call to process
+    size_t get_number_of_clusters() const;
+
+    /// Return the first hit index of a cluster
+    const hit_index_type * cluster_begin(size_t icluster_) const;
+
+    /// Return the past-the-end hit index of a cluster
+    const hit_index_type * cluster_end(size_t icluster_) const;
+
+  private:
+
+    bool _transitive_; //!< Follow neighbours of neighbours
+
+    size_t _nchannels_;                  //!< Number of channels
+    const uint32_t * _offsets_;          //!< CSR row offsets
+    const channel_type * _neighbours_;   //!< CSR neighbour channels
+
+    // Working space, kept from one event to the other:
+    std::vector<int32_t> _hit_slots_;              //!< First hit index per channel (-1 if not hit)
+    std::vector<uint8_t> _used_;                   //!< Used flag per channel
+    std::vector<channel_type> _touched_;           //!< Channels to clean after processing
+    std::vector<channel_type> _queue_;             //!< Channels to explore
+    std::vector<uint32_t> _cluster_offsets_;       //!< Clusters CSR offsets
+    std::vector<hit_index_type> _cluster_members_; //!< Clusters CSR hit indices
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_CALORIMETER_CLUSTERING_H_
+
+// end of calorimeter_clustering.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
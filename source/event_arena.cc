@@ -0,0 +1,139 @@
+// event_arena.cc
+
+// Ourselves:
+#include <event_arena.h>
+
+// Standard library:
+#include <stdexcept>
+#include <functional>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+namespace analysis {
+
+  namespace {
+
+    // Arena used by the allocators of the calling thread
+    thread_local event_arena * the_current_arena = 0;
+
+  }
+
+  const size_t event_arena::DEFAULT_BLOCK_SIZE;
+
+  event_arena::scope::scope(event_arena & arena_)
+  {
+    _previous_ = the_current_arena;
+    the_current_arena = &arena_;
+    return;
+  }
+
+  event_arena::scope::~scope()
+  {
+    the_current_arena = _previous_;
+    return;
+  }
+
+  event_arena * event_arena::current()
+  {
+    return the_current_arena;
+  }
+
+  event_arena::event_arena(size_t block_size_)
+  {
+    DT_THROW_IF(block_size_ == 0, std::domain_error, "Invalid arena block size !");
+    _block_size_ = block_size_;
+    _offset_ = 0;
+    _number_of_allocations_ = 0;
+    _number_of_heap_allocations_ = 0;
+    _number_of_releases_ = 0;
+    _blocks_.reserve(16);
+    return;
+  }
+
+  event_arena::~event_arena()
+  {
+    for (auto & iblock : _blocks_) ::operator delete(iblock.data);
+    return;
+  }
+
+  void * event_arena::allocate(size_t size_, size_t alignment_)
+  {
+    _number_of_allocations_++;
+    if (! _blocks_.empty()) {
+      const block_type & a_block = _blocks_.back();
+      const size_t an_offset = (_offset_ + alignment_ - 1) & ~(alignment_ - 1);
+      if (an_offset + size_ <= a_block.size) {
+        _offset_ = an_offset + size_;
+        return a_block.data + an_offset;
+      }
+    }
+    // Blocks are allocated with the default new alignment
+    _add_block_(size_);
+    _offset_ = size_;
+    return _blocks_.back().data;
+  }
+
+  bool event_arena::owns(const void * pointer_) const
+  {
+    const std::less<const char *> before;
+    const char * a_pointer = static_cast<const char *>(pointer_);
+    for (const auto & iblock : _blocks_) {
+      if (! before(a_pointer, iblock.data) && before(a_pointer, iblock.data + iblock.size)) return true;
+    }
+    return false;
+  }
+
+  void event_arena::release()
+  {
+    _number_of_releases_++;
+    _offset_ = 0;
+    if (_blocks_.size() < 2) return;
+
+    // Merge blocks so that the next event fits in a single one
+    size_t a_size = 0;
+    for (auto & iblock : _blocks_) {
+      a_size += iblock.size;
+      ::operator delete(iblock.data);
+    }
+    _blocks_.clear();
+    _add_block_(a_size);
+    return;
+  }
+
+  size_t event_arena::get_number_of_allocations() const
+  {
+    return _number_of_allocations_;
+  }
+
+  size_t event_arena::get_number_of_heap_allocations() const
+  {
+    return _number_of_heap_allocations_;
+  }
+
+  size_t event_arena::get_number_of_releases() const
+  {
+    return _number_of_releases_;
+  }
+
+  void event_arena::_add_block_(size_t size_)
+  {
+    block_type a_block;
+    a_block.size = size_ > _block_size_ ? size_ : _block_size_;
+    a_block.data = static_cast<char *>(::operator new(a_block.size));
+    _blocks_.push_back(a_block);
+    _number_of_heap_allocations_++;
+    return;
+  }
+
+} // namespace analysis
+
+// end of event_arena.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
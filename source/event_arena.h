@@ -0,0 +1,173 @@
+/* event_arena.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Monotonic memory arena for the containers built while processing an
+ * event. Memory is handed out from large blocks and is only given back
+ * when the arena is released, between two events. When several blocks
+ * have been needed, they are merged into a single one at release so
+ * that, once the largest event has been seen, no more heap allocation
+ * occurs.
+ *
+ * The arena_allocator is stateless: it allocates from the arena made
+ * current in the calling thread by an event_arena::scope object and falls
+ * back to the heap otherwise.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_EVENT_ARENA_H_
+#define ANALYSIS_EVENT_ARENA_H_ 1
+
+// Standard libraries:
+#include <vector>
+#include <new>
+#include <cstddef>
+
+namespace analysis {
+
+  class event_arena
+  {
+  public:
+
+    /// Default size of a memory block
+    static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    /// Make an arena current in the calling thread for the scope lifetime
+    class scope
+    {
+    public:
+
+      /// Constructor
+      scope(event_arena & arena_);
+
+      /// Destructor
+      ~scope();
+
+    private:
+
+      event_arena * _previous_; //!< Arena current before this scope
+    };
+
+    /// Return the arena current in the calling thread (null if none)
+    static event_arena * current();
+
+    /// Constructor
+    event_arena(size_t block_size_ = DEFAULT_BLOCK_SIZE);
+
+    /// Destructor
+    ~event_arena();
+
+    /// Allocate memory
+    void * allocate(size_t size_, size_t alignment_);
+
+    /// Check if some memory has been allocated by the arena
+    bool owns(const void * pointer_) const;
+
+    /// Give all the memory back, to be called once the event containers are destroyed
+    void release();
+
+    /// Return the number of allocations served
+    size_t get_number_of_allocations() const;
+
+    /// Return the number of memory blocks taken from the heap
+    size_t get_number_of_heap_allocations() const;
+
+    /// Return the number of releases
+    size_t get_number_of_releases() const;
+
+  private:
+
+    /// Allocate a new block able to hold a given size
+    void _add_block_(size_t size_);
+
+    /// Memory block
+    struct block_type {
+      char * data;  //!< Block memory
+      size_t size;  //!< Block size
+    };
+
+    event_arena(const event_arena &) = delete;
+    event_arena & operator=(const event_arena &) = delete;
+
+    size_t _block_size_;              //!< Minimal size of a block
+    std::vector<block_type> _blocks_; //!< Memory blocks
+    size_t _offset_;                  //!< First free byte of the last block
+
+    size_t _number_of_allocations_;      //!< Allocations counter
+    size_t _number_of_heap_allocations_; //!< Heap allocations counter
+    size_t _number_of_releases_;         //!< Releases counter
+  };
+
+  /// Standard allocator drawing memory from the current event arena
+  template <class T>
+  class arena_allocator
+  {
+  public:
+
+    typedef T value_type;
+
+    arena_allocator() {}
+
+    template <class U>
+    arena_allocator(const arena_allocator<U> &) {}
+
+    T * allocate(size_t n_)
+    {
+      event_arena * an_arena = event_arena::current();
+      if (an_arena) return static_cast<T *>(an_arena->allocate(n_ * sizeof(T), alignof(T)));
+      return static_cast<T *>(::operator new(n_ * sizeof(T)));
+    }
+
+    void deallocate(T * pointer_, size_t)
+    {
+      // Arena memory is given back at once when the arena is released
+      event_arena * an_arena = event_arena::current();
+      if (an_arena && an_arena->owns(pointer_)) return;
+      ::operator delete(pointer_);
+    }
+  };
+
+  template <class T, class U>
+  bool operator==(const arena_allocator<T> &, const arena_allocator<U> &)
+  {
+    return true;
+  }
+
+  template <class T, class U>
+  bool operator!=(const arena_allocator<T> &, const arena_allocator<U> &)
+  {
+    return false;
+  }
+
+} // namespace analysis
+
+#endif // ANALYSIS_EVENT_ARENA_H_
+
+// end of event_arena.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
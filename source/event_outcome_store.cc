@@ -0,0 +1,266 @@
+// event_outcome_store.cc
+
+// Ourselves:
+#include <event_outcome_store.h>
+
+// Standard library:
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+// - POSIX:
+#include <unistd.h>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+namespace analysis {
+
+  namespace {
+
+    const char MAGIC[8] = {'S', 'N', 'G', 'T', 'R', 'O', 'W', 'S'};
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    uint16_t saturate(size_t value_)
+    {
+      return value_ > 0xffff ? 0xffff : value_;
+    }
+
+    template <class T>
+    void write_column(std::fstream & file_, std::vector<T> & column_, size_t size_)
+    {
+      // Rows of a partial block are padded with zeros
+      std::fill(column_.begin() + size_, column_.end(), T(0));
+      file_.write(reinterpret_cast<const char *>(column_.data()), column_.size() * sizeof(T));
+    }
+
+  }
+
+  const uint32_t event_outcome_store::VERSION;
+  const size_t event_outcome_store::HEADER_SIZE;
+  const size_t event_outcome_store::DEFAULT_BLOCK_ROWS;
+
+  event_outcome_store::block_type::block_type()
+  {
+    _size_ = 0;
+    return;
+  }
+
+  void event_outcome_store::block_type::set_capacity(size_t capacity_)
+  {
+    _size_ = 0;
+    _total_gamma_energy_.assign(capacity_, 0);
+    _run_number_.assign(capacity_, 0);
+    _event_number_.assign(capacity_, 0);
+    _number_of_simulated_gammas_.assign(capacity_, 0);
+    _number_of_reconstructed_gammas_.assign(capacity_, 0);
+    _number_of_clustered_gammas_.assign(capacity_, 0);
+    _number_of_calos_.assign(capacity_, 0);
+    _flags_.assign(capacity_, 0);
+    return;
+  }
+
+  size_t event_outcome_store::block_type::size() const
+  {
+    return _size_;
+  }
+
+  bool event_outcome_store::block_type::is_full() const
+  {
+    return _size_ == _flags_.size();
+  }
+
+  void event_outcome_store::block_type::push_back(const row_type & row_)
+  {
+    DT_THROW_IF(is_full(), std::logic_error, "Event outcome block is full !");
+    _total_gamma_energy_[_size_]             = row_.total_gamma_energy;
+    _run_number_[_size_]                     = row_.run_number;
+    _event_number_[_size_]                   = row_.event_number;
+    _number_of_simulated_gammas_[_size_]     = saturate(row_.number_of_simulated_gammas);
+    _number_of_reconstructed_gammas_[_size_] = saturate(row_.number_of_reconstructed_gammas);
+    _number_of_clustered_gammas_[_size_]     = saturate(row_.number_of_clustered_gammas);
+    _number_of_calos_[_size_]                = saturate(row_.number_of_calos);
+    _flags_[_size_]                          = row_.flags;
+    _size_++;
+    return;
+  }
+
+  void event_outcome_store::block_type::clear()
+  {
+    _size_ = 0;
+    return;
+  }
+
+  event_outcome_store::event_outcome_store()
+  {
+    _block_rows_ = DEFAULT_BLOCK_ROWS;
+    _number_of_rows_ = 0;
+    _number_of_blocks_ = 0;
+    return;
+  }
+
+  event_outcome_store::~event_outcome_store()
+  {
+    if (is_open()) close();
+    return;
+  }
+
+  bool event_outcome_store::is_open() const
+  {
+    return _file_.is_open();
+  }
+
+  void event_outcome_store::open(const std::string & filename_, size_t block_rows_)
+  {
+    DT_THROW_IF(is_open(), std::logic_error, "Event outcome file '" << _filename_ << "' is already open !");
+    DT_THROW_IF(block_rows_ == 0 || block_rows_ % 8 != 0, std::domain_error,
+                "Invalid number of rows per block (" << block_rows_ << ") !");
+    _file_.open(filename_.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    DT_THROW_IF(! _file_, std::runtime_error, "Cannot open event outcome file '" << filename_ << "' !");
+    _filename_ = filename_;
+    _block_rows_ = block_rows_;
+    _number_of_rows_ = 0;
+    _number_of_blocks_ = 0;
+    _write_header_();
+    return;
+  }
+
+  void event_outcome_store::resume(const std::string & filename_, size_t block_rows_, uint64_t number_of_blocks_)
+  {
+    DT_THROW_IF(is_open(), std::logic_error, "Event outcome file '" << _filename_ << "' is already open !");
+    std::fstream a_file(filename_.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    DT_THROW_IF(! a_file, std::runtime_error, "Cannot open event outcome file '" << filename_ << "' to resume it !");
+    char a_header[HEADER_SIZE];
+    a_file.read(a_header, HEADER_SIZE);
+    DT_THROW_IF(! a_file || std::memcmp(a_header, MAGIC, sizeof(MAGIC)) != 0, std::runtime_error,
+                "File '" << filename_ << "' is not an event outcome file !");
+    uint32_t a_version = 0;
+    uint32_t a_byte_order_mark = 0;
+    uint32_t a_block_rows = 0;
+    uint64_t nblocks = 0;
+    std::memcpy(&a_version, a_header + 8, sizeof(a_version));
+    std::memcpy(&a_byte_order_mark, a_header + 12, sizeof(a_byte_order_mark));
+    std::memcpy(&a_block_rows, a_header + 16, sizeof(a_block_rows));
+    std::memcpy(&nblocks, a_header + 32, sizeof(nblocks));
+    DT_THROW_IF(a_version != VERSION || a_byte_order_mark != BYTE_ORDER_MARK, std::runtime_error,
+                "Event outcome file '" << filename_ << "' has another version or byte order !");
+    DT_THROW_IF(a_block_rows != block_rows_, std::logic_error,
+                "Event outcome file '" << filename_ << "' has " << a_block_rows << " rows per block, not "
+                << block_rows_ << " !");
+    DT_THROW_IF(nblocks < number_of_blocks_, std::runtime_error,
+                "Event outcome file '" << filename_ << "' has " << nblocks << " blocks, "
+                << number_of_blocks_ << " were written at the checkpoint !");
+
+    // Blocks written after the checkpoint are dropped, their events are processed again
+    _block_rows_ = block_rows_;
+    _number_of_rows_ = 0;
+    _number_of_blocks_ = number_of_blocks_;
+    for (uint64_t iblock = 0; iblock < number_of_blocks_; iblock++) {
+      uint64_t nrows = 0;
+      a_file.seekg(HEADER_SIZE + iblock * _block_size_());
+      a_file.read(reinterpret_cast<char *>(&nrows), sizeof(nrows));
+      DT_THROW_IF(! a_file || nrows > _block_rows_, std::runtime_error,
+                  "Truncated or corrupted event outcome file '" << filename_ << "' !");
+      _number_of_rows_ += nrows;
+    }
+    a_file.close();
+    DT_THROW_IF(::truncate(filename_.c_str(), HEADER_SIZE + number_of_blocks_ * _block_size_()) != 0, std::runtime_error,
+                "Cannot truncate event outcome file '" << filename_ << "' !");
+
+    _file_.open(filename_.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    DT_THROW_IF(! _file_, std::runtime_error, "Cannot open event outcome file '" << filename_ << "' !");
+    _filename_ = filename_;
+    _write_header_();
+    _file_.seekp(0, std::ios::end);
+    return;
+  }
+
+  size_t event_outcome_store::get_block_rows() const
+  {
+    return _block_rows_;
+  }
+
+  uint64_t event_outcome_store::get_number_of_rows() const
+  {
+    return _number_of_rows_;
+  }
+
+  uint64_t event_outcome_store::get_number_of_blocks() const
+  {
+    return _number_of_blocks_;
+  }
+
+  void event_outcome_store::write(block_type & block_)
+  {
+    if (block_.size() == 0) return;
+    DT_THROW_IF(block_._flags_.size() != _block_rows_, std::logic_error,
+                "Event outcome block capacity differs from the file one !");
+    std::lock_guard<std::mutex> lock(_mutex_);
+    const uint64_t nrows = block_.size();
+    _file_.write(reinterpret_cast<const char *>(&nrows), sizeof(nrows));
+    write_column(_file_, block_._total_gamma_energy_, block_._size_);
+    write_column(_file_, block_._run_number_, block_._size_);
+    write_column(_file_, block_._event_number_, block_._size_);
+    write_column(_file_, block_._number_of_simulated_gammas_, block_._size_);
+    write_column(_file_, block_._number_of_reconstructed_gammas_, block_._size_);
+    write_column(_file_, block_._number_of_clustered_gammas_, block_._size_);
+    write_column(_file_, block_._number_of_calos_, block_._size_);
+    write_column(_file_, block_._flags_, block_._size_);
+    DT_THROW_IF(! _file_, std::runtime_error, "Cannot write event outcome file '" << _filename_ << "' !");
+    _number_of_rows_ += nrows;
+    _number_of_blocks_++;
+    block_.clear();
+
+    // The header is kept up to date so that the file holds every block written
+    _file_.seekp(0);
+    _write_header_();
+    _file_.seekp(0, std::ios::end);
+    _file_.flush();
+    DT_THROW_IF(! _file_, std::runtime_error, "Cannot write event outcome file '" << _filename_ << "' !");
+    return;
+  }
+
+  void event_outcome_store::close()
+  {
+    DT_THROW_IF(! is_open(), std::logic_error, "No event outcome file is open !");
+    _file_.close();
+    return;
+  }
+
+  size_t event_outcome_store::_block_size_() const
+  {
+    return sizeof(uint64_t) + _block_rows_ * (sizeof(double) + 2 * sizeof(int32_t) + 4 * sizeof(uint16_t) + sizeof(uint8_t));
+  }
+
+  void event_outcome_store::_write_header_()
+  {
+    char a_header[HEADER_SIZE] = {0};
+    char * a_cursor = a_header;
+    auto a_field = [&a_cursor] (const void * data_, size_t size_) {
+      std::copy(static_cast<const char *>(data_), static_cast<const char *>(data_) + size_, a_cursor);
+      a_cursor += size_;
+    };
+    const uint32_t a_block_rows = _block_rows_;
+    const uint32_t a_padding = 0;
+    a_field(MAGIC, sizeof(MAGIC));
+    a_field(&VERSION, sizeof(VERSION));
+    a_field(&BYTE_ORDER_MARK, sizeof(BYTE_ORDER_MARK));
+    a_field(&a_block_rows, sizeof(a_block_rows));
+    a_field(&a_padding, sizeof(a_padding));
+    a_field(&_number_of_rows_, sizeof(_number_of_rows_));
+    a_field(&_number_of_blocks_, sizeof(_number_of_blocks_));
+    _file_.write(a_header, HEADER_SIZE);
+    DT_THROW_IF(! _file_, std::runtime_error, "Cannot write event outcome file '" << _filename_ << "' header !");
+    return;
+  }
+
+} // namespace analysis
+
+// end of event_outcome_store.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
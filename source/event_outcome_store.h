@@ -0,0 +1,194 @@
+/* event_outcome_store.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Columnar binary file with one fixed width row per processed event, meant
+ * to be memory mapped by downstream studies. The file is made of a 64
+ * bytes header followed by blocks of 'block_rows' rows; in each block,
+ * every column is stored contiguously, so that the offset of any column of
+ * any block is known from the header only:
+ *
+ *   header : magic "SNGTROWS", uint32 version, uint32 byte order mark
+ *            (0x01020304 in host order), uint32 block_rows, uint32 padding,
+ *            uint64 number of rows, uint64 number of blocks, zero padding
+ *   block  : uint64 number of rows in the block (<= block_rows), then
+ *            double   total_gamma_energy[block_rows]
+ *            int32    run_number[block_rows]
+ *            int32    event_number[block_rows]
+ *            uint16   number_of_simulated_gammas[block_rows]
+ *            uint16   number_of_reconstructed_gammas[block_rows]
+ *            uint16   number_of_clustered_gammas[block_rows]
+ *            uint16   number_of_calos[block_rows]
+ *            uint8    flags[block_rows]
+ *
+ * Values are stored in host byte order. Each processing thread fills its
+ * own block and hands it over when full, thus rows are not in input order;
+ * the run and event numbers identify them. Counts above 65535 saturate.
+ * The header is updated and the file flushed after every block, so that
+ * an interrupted job leaves every block handed over readable; a resumed
+ * job appends to the blocks written up to its checkpoint.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_EVENT_OUTCOME_STORE_H_
+#define ANALYSIS_EVENT_OUTCOME_STORE_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <vector>
+#include <fstream>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+namespace analysis {
+
+  class event_outcome_store
+  {
+  public:
+
+    /// Current format version
+    static const uint32_t VERSION = 1;
+
+    /// Size of the file header
+    static const size_t HEADER_SIZE = 64;
+
+    /// Default number of rows per block
+    static const size_t DEFAULT_BLOCK_ROWS = 4096;
+
+    /// Event outcome flags
+    enum flag_type {
+      COMPARED      = 0x1, //!< Simulated sequences have been compared
+      GT_MATCHED    = 0x2, //!< All simulated gammas are reconstructed
+      NO_GT_MATCHED = 0x4, //!< All simulated gammas are clustered
+      PREFILTERED   = 0x8  //!< Rejected by the event pre-filter
+    };
+
+    /// Outcome of an event
+    struct row_type {
+      int32_t run_number;     //!< Run number (-1 if unknown)
+      int32_t event_number;   //!< Event number (-1 if unknown)
+      size_t number_of_simulated_gammas;     //!< Simulated gamma sequences
+      size_t number_of_reconstructed_gammas; //!< Reconstructed gamma sequences
+      size_t number_of_clustered_gammas;     //!< Clustered gamma sequences
+      size_t number_of_calos; //!< Calibrated calorimeters
+      double total_gamma_energy; //!< Energy of the reconstructed gammas
+      uint8_t flags;          //!< Outcome flags
+    };
+
+    /// Rows of a block, column by column
+    class block_type
+    {
+    public:
+
+      /// Constructor
+      block_type();
+
+      /// Set the capacity
+      void set_capacity(size_t capacity_);
+
+      /// Return the number of rows
+      size_t size() const;
+
+      /// Check if there is no more room
+      bool is_full() const;
+
+      /// Add a row
+      void push_back(const row_type & row_);
+
+      /// Remove all rows
+      void clear();
+
+    private:
+
+      friend class event_outcome_store;
+
+      size_t _size_; //!< Number of rows
+      std::vector<double>   _total_gamma_energy_;
+      std::vector<int32_t>  _run_number_;
+      std::vector<int32_t>  _event_number_;
+      std::vector<uint16_t> _number_of_simulated_gammas_;
+      std::vector<uint16_t> _number_of_reconstructed_gammas_;
+      std::vector<uint16_t> _number_of_clustered_gammas_;
+      std::vector<uint16_t> _number_of_calos_;
+      std::vector<uint8_t>  _flags_;
+    };
+
+    /// Constructor
+    event_outcome_store();
+
+    /// Destructor
+    ~event_outcome_store();
+
+    /// Check if a file is open
+    bool is_open() const;
+
+    /// Open a file (block_rows must be a multiple of 8)
+    void open(const std::string & filename_, size_t block_rows_ = DEFAULT_BLOCK_ROWS);
+
+    /// Open an existing file to append blocks, keeping only its first 'number_of_blocks_' blocks
+    void resume(const std::string & filename_, size_t block_rows_, uint64_t number_of_blocks_);
+
+    /// Return the number of rows per block
+    size_t get_block_rows() const;
+
+    /// Return the number of rows written
+    uint64_t get_number_of_rows() const;
+
+    /// Return the number of blocks written
+    uint64_t get_number_of_blocks() const;
+
+    /// Write a block (possibly partial), update the header and clear the block, may be called concurrently
+    void write(block_type & block_);
+
+    /// Close the file
+    void close();
+
+  private:
+
+    /// Return the size of a block in the file
+    size_t _block_size_() const;
+
+    /// Write the file header
+    void _write_header_();
+
+    std::fstream _file_;        //!< Output file
+    std::string _filename_;     //!< Output file name
+    size_t _block_rows_;        //!< Number of rows per block
+    uint64_t _number_of_rows_;  //!< Number of rows written
+    uint64_t _number_of_blocks_; //!< Number of blocks written
+    std::mutex _mutex_;         //!< Serialize block writes
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_EVENT_OUTCOME_STORE_H_
+
+// end of event_outcome_store.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
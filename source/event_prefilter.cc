@@ -0,0 +1,143 @@
+// event_prefilter.cc
+
+// Ourselves:
+#include <event_prefilter.h>
+
+// Standard library:
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+// This project:
+#include <gamma_event_view.h>
+#include <run_state.h>
+
+namespace analysis {
+
+  const char * event_prefilter::get_predicate_name(predicate_id predicate_)
+  {
+    switch (predicate_) {
+    case SIMULATED_DATA:      return "simulated_data";
+    case CALIBRATED_DATA:     return "calibrated_data";
+    case PARTICLE_TRACK_DATA: return "particle_track_data";
+    case STEP_HITS:           return "step_hits";
+    case CALIBRATED_CALOS:    return "calibrated_calos";
+    case GAMMAS:              return "gammas";
+    default:                  return "";
+    }
+  }
+
+  event_prefilter::predicate_id event_prefilter::get_predicate(const std::string & name_)
+  {
+    for (size_t i = 0; i < NUMBER_OF_PREDICATES; i++) {
+      const predicate_id a_predicate = static_cast<predicate_id>(i);
+      if (name_ == get_predicate_name(a_predicate)) return a_predicate;
+    }
+    DT_THROW(std::logic_error, "Unknown event pre-filter predicate '" << name_ << "' !");
+  }
+
+  event_prefilter::event_prefilter()
+  {
+    reset();
+    return;
+  }
+
+  void event_prefilter::reset()
+  {
+    _predicates_.clear();
+    for (size_t i = 0; i < NUMBER_OF_PREDICATES; i++) _minimums_[i] = 1;
+    clear();
+    return;
+  }
+
+  bool event_prefilter::is_enabled() const
+  {
+    return ! _predicates_.empty();
+  }
+
+  void event_prefilter::add_predicate(predicate_id predicate_)
+  {
+    for (const auto ipredicate : _predicates_) {
+      DT_THROW_IF(ipredicate == predicate_, std::logic_error,
+                  "Event pre-filter predicate '" << get_predicate_name(predicate_) << "' is already checked !");
+    }
+    _predicates_.push_back(predicate_);
+    return;
+  }
+
+  const std::vector<event_prefilter::predicate_id> & event_prefilter::get_predicates() const
+  {
+    return _predicates_;
+  }
+
+  void event_prefilter::set_minimum(predicate_id predicate_, size_t minimum_)
+  {
+    _minimums_[predicate_] = minimum_;
+    return;
+  }
+
+  size_t event_prefilter::get_minimum(predicate_id predicate_) const
+  {
+    return _minimums_[predicate_];
+  }
+
+  bool event_prefilter::accept(const gamma_event_view & event_)
+  {
+    for (const auto ipredicate : _predicates_) {
+      bool passed = true;
+      switch (ipredicate) {
+      case SIMULATED_DATA:      passed = event_.sd != 0; break;
+      case CALIBRATED_DATA:     passed = event_.cd != 0; break;
+      case PARTICLE_TRACK_DATA: passed = event_.ptd != 0; break;
+      case STEP_HITS:           passed = event_.number_of_step_hits >= _minimums_[STEP_HITS]; break;
+      case CALIBRATED_CALOS:    passed = event_.number_of_calibrated_hits >= _minimums_[CALIBRATED_CALOS]; break;
+      case GAMMAS:              passed = event_.number_of_neutral_particles >= _minimums_[GAMMAS]; break;
+      default:                  break;
+      }
+      if (passed) continue;
+      _rejected_[ipredicate].fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    return true;
+  }
+
+  uint64_t event_prefilter::get_rejected(predicate_id predicate_) const
+  {
+    return _rejected_[predicate_].load(std::memory_order_relaxed);
+  }
+
+  void event_prefilter::clear()
+  {
+    for (size_t i = 0; i < NUMBER_OF_PREDICATES; i++) _rejected_[i] = 0;
+    return;
+  }
+
+  void event_prefilter::export_counters(run_state & state_, const std::string & prefix_) const
+  {
+    for (const auto ipredicate : _predicates_) {
+      state_.set_counter(prefix_ + get_predicate_name(ipredicate), get_rejected(ipredicate));
+    }
+    return;
+  }
+
+  void event_prefilter::import_counters(const run_state & state_, const std::string & prefix_)
+  {
+    for (size_t i = 0; i < NUMBER_OF_PREDICATES; i++) {
+      const std::string a_name = prefix_ + get_predicate_name(static_cast<predicate_id>(i));
+      if (state_.has_counter(a_name)) _rejected_[i] += state_.get_counter(a_name);
+    }
+    return;
+  }
+
+} // namespace analysis
+
+// end of event_prefilter.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,124 @@
+/* event_prefilter.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Ordered list of cheap predicates checked on the banks of an event once
+ * they are looked up, before any hit is decoded: bank presence and minimum
+ * numbers of step hits, calibrated calorimeter hits and reconstructed
+ * gammas. The first failing predicate rejects the event and is counted,
+ * with a relaxed atomic increment so that the filter may be shared by the
+ * processing threads.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_EVENT_PREFILTER_H_
+#define ANALYSIS_EVENT_PREFILTER_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace analysis {
+
+  class run_state;
+  class gamma_event_view;
+
+  class event_prefilter
+  {
+  public:
+
+    /// Predicates
+    enum predicate_id {
+      SIMULATED_DATA       = 0, //!< Simulated data bank found
+      CALIBRATED_DATA      = 1, //!< Calibrated data bank found
+      PARTICLE_TRACK_DATA  = 2, //!< Particle track data bank found
+      STEP_HITS            = 3, //!< Minimum number of simulated calorimeter step hits
+      CALIBRATED_CALOS     = 4, //!< Minimum number of calibrated calorimeter hits
+      GAMMAS               = 5, //!< Minimum number of reconstructed gammas
+      NUMBER_OF_PREDICATES = 6
+    };
+
+    /// Return the name of a predicate
+    static const char * get_predicate_name(predicate_id predicate_);
+
+    /// Return the predicate of a given name
+    static predicate_id get_predicate(const std::string & name_);
+
+    /// Constructor
+    event_prefilter();
+
+    /// Remove the predicates, restore the default minimums and zero the counters
+    void reset();
+
+    /// Check if some predicate is checked
+    bool is_enabled() const;
+
+    /// Append a predicate to the checked ones
+    void add_predicate(predicate_id predicate_);
+
+    /// Return the checked predicates, in order
+    const std::vector<predicate_id> & get_predicates() const;
+
+    /// Set the minimum number of a counting predicate (1 by default)
+    void set_minimum(predicate_id predicate_, size_t minimum_);
+
+    /// Return the minimum number of a counting predicate
+    size_t get_minimum(predicate_id predicate_) const;
+
+    /// Check the predicates on looked up banks, count the rejecting one
+    bool accept(const gamma_event_view & event_);
+
+    /// Return the number of events rejected by a predicate
+    uint64_t get_rejected(predicate_id predicate_) const;
+
+    /// Zero the counters
+    void clear();
+
+    /// Store the counters in a run state
+    void export_counters(run_state & state_, const std::string & prefix_) const;
+
+    /// Add the counters found in a run state
+    void import_counters(const run_state & state_, const std::string & prefix_);
+
+  private:
+
+    std::vector<predicate_id> _predicates_;              //!< Checked predicates
+    size_t _minimums_[NUMBER_OF_PREDICATES];             //!< Minimum numbers of the counting predicates
+    std::atomic<uint64_t> _rejected_[NUMBER_OF_PREDICATES]; //!< Rejected events per predicate
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_EVENT_PREFILTER_H_
+
+// end of event_prefilter.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
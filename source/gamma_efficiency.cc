@@ -0,0 +1,120 @@
+// gamma_efficiency.cc
+
+// Ourselves:
+#include <gamma_efficiency.h>
+
+// This project:
+#include <run_state.h>
+
+namespace analysis {
+
+  namespace {
+
+    /// Print a ratio of counters
+    void print_ratio(std::ostream & out_, const std::string & label_, size_t numerator_, size_t denominator_)
+    {
+      out_ << label_ << " = " << numerator_ << " / " << denominator_
+           << " ( " << numerator_/(double)denominator_*100 << " %)" << std::endl;
+    }
+
+  }
+
+  bool gamma_efficiency::add_comparison(size_t nsimulated_, size_t nreconstructed_, size_t nidentical_)
+  {
+    nevent++;
+
+    if (nreconstructed_ == 0 && nsimulated_ == 0)
+      {
+        nmiss++;
+        return false;
+      }
+
+    ntotal += nsimulated_;
+    if (nsimulated_ > 0) nevent_gammas++;
+    ngood += nidentical_;
+
+    if (nidentical_ == nsimulated_ && nsimulated_ > 0)
+      {
+        ngood_event++;
+        return true;
+      }
+    return false;
+  }
+
+  bool gamma_efficiency::add_cluster_comparison(size_t nsimulated_, size_t nclustered_, size_t nidentical_)
+  {
+    if (nclustered_ == 0 && nsimulated_ == 0) return false;
+
+    if (nsimulated_ > 0) no_gt_nevent_gammas++;
+
+    if (nidentical_ == nsimulated_ && nsimulated_ > 0)
+      {
+        no_gt_ngood_event++;
+        return true;
+      }
+    return false;
+  }
+
+  void gamma_efficiency::merge(const gamma_efficiency & other_)
+  {
+    nevent              += other_.nevent;
+    ntotal              += other_.ntotal;
+    ngood               += other_.ngood;
+    nmiss               += other_.nmiss;
+    ngood_event         += other_.ngood_event;
+    nevent_gammas       += other_.nevent_gammas;
+    no_gt_ngood_event   += other_.no_gt_ngood_event;
+    no_gt_nevent_gammas += other_.no_gt_nevent_gammas;
+    return;
+  }
+
+  void gamma_efficiency::export_counters(run_state & state_, const std::string & prefix_) const
+  {
+    state_.set_counter(prefix_ + "nevent",              nevent);
+    state_.set_counter(prefix_ + "ntotal",              ntotal);
+    state_.set_counter(prefix_ + "ngood",               ngood);
+    state_.set_counter(prefix_ + "nmiss",               nmiss);
+    state_.set_counter(prefix_ + "ngood_event",         ngood_event);
+    state_.set_counter(prefix_ + "nevent_gammas",       nevent_gammas);
+    state_.set_counter(prefix_ + "no_gt_ngood_event",   no_gt_ngood_event);
+    state_.set_counter(prefix_ + "no_gt_nevent_gammas", no_gt_nevent_gammas);
+    return;
+  }
+
+  void gamma_efficiency::import_counters(const run_state & state_, const std::string & prefix_)
+  {
+    nevent              += state_.get_counter(prefix_ + "nevent");
+    ntotal              += state_.get_counter(prefix_ + "ntotal");
+    ngood               += state_.get_counter(prefix_ + "ngood");
+    nmiss               += state_.get_counter(prefix_ + "nmiss");
+    ngood_event         += state_.get_counter(prefix_ + "ngood_event");
+    nevent_gammas       += state_.get_counter(prefix_ + "nevent_gammas");
+    no_gt_ngood_event   += state_.get_counter(prefix_ + "no_gt_ngood_event");
+    no_gt_nevent_gammas += state_.get_counter(prefix_ + "no_gt_nevent_gammas");
+    return;
+  }
+
+  void gamma_efficiency::print(std::ostream & out_,
+                               const gamma_efficiency & efficiency_,
+                               const gamma_efficiency & no_gt_efficiency_)
+  {
+    print_ratio(out_, "Number of gammas well reconstructed", efficiency_.ngood, efficiency_.ntotal);
+    print_ratio(out_, "Number of gammas missed", efficiency_.nmiss, efficiency_.nevent);
+    print_ratio(out_, "Number of events successfully reconstructed", efficiency_.ngood_event, efficiency_.nevent);
+    print_ratio(out_, "Number of events with gammas successfully reconstructed",
+                efficiency_.ngood_event, efficiency_.nevent_gammas);
+    print_ratio(out_, "Number of events with gammas successfully clustered",
+                no_gt_efficiency_.no_gt_ngood_event, no_gt_efficiency_.no_gt_nevent_gammas);
+    return;
+  }
+
+} // namespace analysis
+
+// end of gamma_efficiency.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,91 @@
+/* gamma_efficiency.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Counters of the gamma tracking efficiency and the rules updating them
+ * from the comparison of simulated sequences with reconstructed (gamma
+ * tracking) or clustered (no gamma tracking) ones. Shared by the module
+ * and the replay program so that both count events the same way.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_GAMMA_EFFICIENCY_H_
+#define ANALYSIS_GAMMA_EFFICIENCY_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <iostream>
+#include <cstddef>
+
+namespace analysis {
+
+  class run_state;
+
+  /// Efficiency counters
+  struct gamma_efficiency {
+    size_t nevent; //!< Total number of event processed
+    size_t ntotal; //!< Total number of gammas simulated
+    size_t ngamma; //!< Number of gammas simulated for each event
+    size_t ngood;  //!< Number of gammas well reconstructed
+    size_t nmiss;  //!< Number of gammas that do not trigger detector
+    size_t ngood_event;  //!< Number of events fully and successfully reconstructed
+    size_t nevent_gammas;  //!< Number of events with at least one gamma
+
+    size_t no_gt_ngood_event;  //!< Number of events fully and successfully reconstructed
+    size_t no_gt_nevent_gammas;  //!< Number of events with at least one gamma
+
+    /// Account for the comparison of simulated and reconstructed sequences,
+    /// return true if all the simulated gammas are reconstructed
+    bool add_comparison(size_t nsimulated_, size_t nreconstructed_, size_t nidentical_);
+
+    /// Account for the comparison of simulated and clustered sequences,
+    /// return true if all the simulated gammas are clustered
+    bool add_cluster_comparison(size_t nsimulated_, size_t nclustered_, size_t nidentical_);
+
+    /// Add counters (the per event 'ngamma' excepted)
+    void merge(const gamma_efficiency & other_);
+
+    /// Store counters (the per event 'ngamma' excepted) in a run state
+    void export_counters(run_state & state_, const std::string & prefix_) const;
+
+    /// Add counters from a run state
+    void import_counters(const run_state & state_, const std::string & prefix_);
+
+    /// Print the efficiencies as the module does at reset
+    static void print(std::ostream & out_,
+                      const gamma_efficiency & efficiency_,
+                      const gamma_efficiency & no_gt_efficiency_);
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_GAMMA_EFFICIENCY_H_
+
+// end of gamma_efficiency.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,219 @@
+// gamma_event_view.cc
+
+// Ourselves:
+#include <gamma_event_view.h>
+
+// Standard library:
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+#include <datatools/things.h>
+// - Bayeux/mctools
+#include <mctools/utils.h>
+#include <mctools/simulated_data.h>
+
+// - Falaise
+#include <snemo/datamodels/data_model.h>
+#include <snemo/datamodels/event_header.h>
+#include <snemo/datamodels/particle_track.h>
+
+namespace analysis {
+
+  gamma_event_view::gamma_event_view()
+  {
+    _channels_ = 0;
+    clear();
+    return;
+  }
+
+  bool gamma_event_view::is_initialized() const
+  {
+    return _channels_ != 0;
+  }
+
+  const std::string & gamma_event_view::default_step_hit_category()
+  {
+    static const std::string _label("__visu.tracks.calo");
+    return _label;
+  }
+
+  void gamma_event_view::initialize(const calorimeter_channel_index & channels_)
+  {
+    initialize(channels_, std::vector<std::string>(1, default_step_hit_category()));
+    return;
+  }
+
+  void gamma_event_view::initialize(const calorimeter_channel_index & channels_,
+                                    const std::vector<std::string> & step_hit_categories_)
+  {
+    DT_THROW_IF(is_initialized(), std::logic_error, "Event view is already initialized !");
+    DT_THROW_IF(! channels_.is_initialized(), std::logic_error, "Channel index is not initialized !");
+    DT_THROW_IF(step_hit_categories_.empty(), std::logic_error, "Missing step hit category !");
+    _channels_ = &channels_;
+    _sd_label_  = snemo::datamodel::data_info::default_simulated_data_label();
+    _cd_label_  = snemo::datamodel::data_info::default_calibrated_data_label();
+    _ptd_label_ = snemo::datamodel::data_info::default_particle_track_data_label();
+    _eh_label_  = snemo::datamodel::data_info::default_event_header_label();
+    _step_hit_categories_ = step_hit_categories_;
+    return;
+  }
+
+  void gamma_event_view::reset()
+  {
+    clear();
+    _channels_ = 0;
+    _sd_label_.clear();
+    _cd_label_.clear();
+    _ptd_label_.clear();
+    _eh_label_.clear();
+    _step_hit_categories_.clear();
+    return;
+  }
+
+  void gamma_event_view::clear()
+  {
+    sd  = 0;
+    cd  = 0;
+    ptd = 0;
+    eh  = 0;
+    number_of_primary_gammas = 0;
+    number_of_step_hits = 0;
+    number_of_calibrated_hits = 0;
+    number_of_neutral_particles = 0;
+    calibrated_channels.clear();
+    calibrated_times.clear();
+    calibrated_energies.clear();
+    gamma_track_ids.clear();
+    gamma_offsets.assign(1, 0);
+    gamma_tracks.clear();
+    hit_channels.clear();
+    hit_times.clear();
+    hit_energies.clear();
+    hit_gammas.clear();
+    hit_handles.clear();
+    has_step_hits = false;
+    step_channels.clear();
+    step_track_ids.clear();
+    step_hits.clear();
+    return;
+  }
+
+  void gamma_event_view::extract(const datatools::things & data_record_)
+  {
+    lookup(data_record_);
+    decode();
+    return;
+  }
+
+  void gamma_event_view::lookup(const datatools::things & data_record_)
+  {
+    DT_THROW_IF(! is_initialized(), std::logic_error, "Event view is not initialized !");
+    clear();
+
+    if (data_record_.has(_eh_label_)) {
+      eh = &data_record_.get<snemo::datamodel::event_header>(_eh_label_);
+    }
+
+    if (data_record_.has(_sd_label_)) {
+      sd = &data_record_.get<mctools::simulated_data>(_sd_label_);
+      for (const auto & iparticle : sd->get_primary_event().get_particles()) {
+        if (iparticle.is_gamma()) number_of_primary_gammas++;
+      }
+      for (const auto & icategory : _step_hit_categories_) {
+        if (! sd->has_step_hits(icategory)) continue;
+        has_step_hits = true;
+        number_of_step_hits += sd->get_number_of_step_hits(icategory);
+      }
+    }
+
+    if (data_record_.has(_cd_label_)) {
+      cd = &data_record_.get<snemo::datamodel::calibrated_data>(_cd_label_);
+      if (cd->has_calibrated_calorimeter_hits()) {
+        number_of_calibrated_hits = cd->calibrated_calorimeter_hits().size();
+      }
+    }
+
+    if (data_record_.has(_ptd_label_)) {
+      ptd = &data_record_.get<snemo::datamodel::particle_track_data>(_ptd_label_);
+      _particles_.clear();
+      ptd->fetch_particles(_particles_, snemo::datamodel::particle_track::NEUTRAL);
+      number_of_neutral_particles = _particles_.size();
+    }
+    return;
+  }
+
+  void gamma_event_view::decode()
+  {
+    if (sd) {
+      // Fetch simulated step hits from calorimeter blocks, categories hold
+      // distinct blocks so that their hits are simply concatenated
+      for (const auto & icategory : _step_hit_categories_) {
+        if (! sd->has_step_hits(icategory)) continue;
+        for (const auto & ihit : sd->get_step_hits(icategory)) {
+          const mctools::base_step_hit & a_hit = ihit.get();
+          const datatools::properties & a_aux = a_hit.get_auxiliaries();
+          // The parent track id, if any, takes precedence over the track id
+          int track_id = -1;
+          if (a_aux.has_key(mctools::track_utils::TRACK_ID_KEY)) {
+            track_id = a_aux.fetch_integer(mctools::track_utils::TRACK_ID_KEY);
+          }
+          if (a_aux.has_key(mctools::track_utils::PARENT_TRACK_ID_KEY)) {
+            track_id = a_aux.fetch_integer(mctools::track_utils::PARENT_TRACK_ID_KEY);
+          }
+          step_channels.push_back(_channels_->get_channel(a_hit.get_geom_id()));
+          step_track_ids.push_back(track_id);
+          step_hits.push_back(&a_hit);
+        }
+      }
+    }
+
+    if (cd && cd->has_calibrated_calorimeter_hits()) {
+      for (const auto & icalo : cd->calibrated_calorimeter_hits()) {
+        calibrated_channels.push_back(_channels_->get_channel(icalo.get().get_geom_id()));
+        calibrated_times.push_back(icalo.get().get_time());
+        calibrated_energies.push_back(icalo.get().get_energy());
+      }
+    }
+
+    if (ptd) {
+      for (const auto & igamma : _particles_) {
+        const snemo::datamodel::particle_track & a_gamma = igamma.get();
+        const uint32_t a_gamma_index = gamma_track_ids.size();
+        for (const auto & icalo : a_gamma.get_associated_calorimeter_hits()) {
+          const snemo::datamodel::calibrated_calorimeter_hit & a_hit = icalo.get();
+          hit_channels.push_back(_channels_->get_channel(a_hit.get_geom_id()));
+          hit_times.push_back(a_hit.get_time());
+          hit_energies.push_back(a_hit.get_energy());
+          hit_gammas.push_back(a_gamma_index);
+          hit_handles.push_back(&icalo);
+        }
+        gamma_track_ids.push_back(a_gamma.get_track_id());
+        gamma_tracks.push_back(&a_gamma);
+        gamma_offsets.push_back(hit_channels.size());
+      }
+    }
+    return;
+  }
+
+  size_t gamma_event_view::get_number_of_gammas() const
+  {
+    return gamma_track_ids.size();
+  }
+
+  size_t gamma_event_view::get_number_of_hits() const
+  {
+    return hit_channels.size();
+  }
+
+} // namespace analysis
+
+// end of gamma_event_view.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,180 @@
+/* gamma_event_view.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Flat view of the event content used by the gamma tracking efficiency
+ * module. Banks are looked up once per event and the calorimeter hits are
+ * decoded into structure-of-arrays tables (banks may be looked up and
+ * counted first, so that events can be rejected before decoding them):
+ *  - hits associated to reconstructed gammas: channel, time, energy and
+ *    owning gamma,
+ *  - simulated calorimeter step hits: channel and truth track id, read
+ *    from the visualization tracks or from the regular step hit
+ *    categories ('calo', 'xcalo', 'gveto'),
+ *  - channels of the calibrated calorimeter hits.
+ * Tables are kept from one event to the other to avoid memory allocation.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_GAMMA_EVENT_VIEW_H_
+#define ANALYSIS_GAMMA_EVENT_VIEW_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <vector>
+#include <cstdint>
+// Third party:
+// - Falaise
+#include <snemo/datamodels/calibrated_data.h>
+#include <snemo/datamodels/particle_track_data.h>
+
+// This project:
+#include <calorimeter_channel_index.h>
+
+namespace datatools {
+  class things;
+}
+
+namespace mctools {
+  class simulated_data;
+  class base_step_hit;
+}
+
+namespace snemo {
+  namespace datamodel {
+    class event_header;
+  }
+}
+
+namespace analysis {
+
+  class gamma_event_view
+  {
+  public:
+
+    /// Typedef for dense channel number
+    typedef calorimeter_channel_index::channel_type channel_type;
+
+    /// Typedef for calorimeter hit handle
+    typedef snemo::datamodel::calibrated_calorimeter_hit::handle_type hit_handle_type;
+
+    /// Constructor
+    gamma_event_view();
+
+    /// Check initialization flag
+    bool is_initialized() const;
+
+    /// Default category of the simulated calorimeter step hits
+    static const std::string & default_step_hit_category();
+
+    /// Set the channel numbering and the bank labels
+    void initialize(const calorimeter_channel_index & channels_);
+
+    /// Set the channel numbering, the bank labels and the categories of the simulated calorimeter step hits
+    void initialize(const calorimeter_channel_index & channels_,
+                    const std::vector<std::string> & step_hit_categories_);
+
+    /// Reset
+    void reset();
+
+    /// Clear the event content
+    void clear();
+
+    /// Decode an event
+    void extract(const datatools::things & data_record_);
+
+    /// Look up the banks of an event and count their content, without decoding the hits
+    void lookup(const datatools::things & data_record_);
+
+    /// Decode the hits of the banks found by 'lookup'
+    void decode();
+
+    /// Return the number of reconstructed gammas
+    size_t get_number_of_gammas() const;
+
+    /// Return the number of hits associated to reconstructed gammas
+    size_t get_number_of_hits() const;
+
+    // Banks, null if missing:
+    const mctools::simulated_data * sd;                      //!< Simulated data
+    const snemo::datamodel::calibrated_data * cd;            //!< Calibrated data
+    const snemo::datamodel::particle_track_data * ptd;       //!< Particle track data
+    const snemo::datamodel::event_header * eh;               //!< Event header
+
+    size_t number_of_primary_gammas; //!< Number of simulated primary gammas
+
+    // Bank contents, counted at lookup:
+    size_t number_of_step_hits;         //!< Simulated calorimeter step hits
+    size_t number_of_calibrated_hits;   //!< Calibrated calorimeter hits
+    size_t number_of_neutral_particles; //!< Reconstructed gammas
+
+    // Calibrated calorimeter hits:
+    std::vector<channel_type> calibrated_channels; //!< Channels (INVALID_CHANNEL if unknown)
+    std::vector<double>       calibrated_times;    //!< Times
+    std::vector<double>       calibrated_energies; //!< Energies
+
+    // Reconstructed gammas:
+    std::vector<int>      gamma_track_ids; //!< Track ids
+    std::vector<uint32_t> gamma_offsets;   //!< First hit of each gamma (size = number of gammas + 1)
+    std::vector<const snemo::datamodel::particle_track *> gamma_tracks; //!< Particle tracks
+
+    // Hits associated to reconstructed gammas:
+    std::vector<channel_type> hit_channels;  //!< Channels (INVALID_CHANNEL if unknown)
+    std::vector<double>       hit_times;     //!< Times
+    std::vector<double>       hit_energies;  //!< Energies
+    std::vector<uint32_t>     hit_gammas;    //!< Owning gamma index
+    std::vector<const hit_handle_type *> hit_handles; //!< Calibrated hits
+
+    // Simulated calorimeter step hits:
+    bool has_step_hits; //!< Step hits found in one of the categories at least
+    std::vector<channel_type> step_channels;  //!< Channels (INVALID_CHANNEL if unknown)
+    std::vector<int>          step_track_ids; //!< Primary track ids (-1 if missing)
+    std::vector<const mctools::base_step_hit *> step_hits; //!< Step hits
+
+  private:
+
+    const calorimeter_channel_index * _channels_; //!< Channel numbering
+
+    // Bank labels, built once:
+    std::string _sd_label_;
+    std::string _cd_label_;
+    std::string _ptd_label_;
+    std::string _eh_label_;
+    std::vector<std::string> _step_hit_categories_;
+
+    // Working space:
+    snemo::datamodel::particle_track_data::particle_collection_type _particles_;
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_GAMMA_EVENT_VIEW_H_
+
+// end of gamma_event_view.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,247 @@
+// gamma_sequence_builder.cc
+
+// Ourselves:
+#include <gamma_sequence_builder.h>
+
+// Standard library:
+#include <algorithm>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+namespace analysis {
+
+  namespace {
+
+    /// Per channel flags
+    enum channel_flag_type {
+      CHANNEL_CALIBRATED = 0x1, //!< Channel has a calibrated hit
+      CHANNEL_ATTRIBUTED = 0x2  //!< Channel is attributed to a simulated gamma
+    };
+
+  }
+
+  const double gamma_sequence_builder::DEFAULT_TIME_GAP = 2.5;
+
+  gamma_sequence_builder::gamma_sequence_builder()
+  {
+    _time_gap_ = DEFAULT_TIME_GAP;
+    return;
+  }
+
+  void gamma_sequence_builder::initialize(size_t nchannels_,
+                                          const uint32_t * offsets_,
+                                          const channel_type * neighbours_,
+                                          bool transitive_)
+  {
+    _clustering_.set_transitive(transitive_);
+    _clustering_.set_neighbourhood(nchannels_, offsets_, neighbours_);
+    _channel_clusters_.assign(nchannels_, 0);
+    _channel_flags_.assign(nchannels_, 0);
+    _touched_channels_.clear();
+    return;
+  }
+
+  double gamma_sequence_builder::get_time_gap() const
+  {
+    return _time_gap_;
+  }
+
+  void gamma_sequence_builder::set_time_gap(double gap_)
+  {
+    DT_THROW_IF(gap_ < 0, std::domain_error, "Invalid negative time gap (" << gap_ << ") !");
+    _time_gap_ = gap_;
+    return;
+  }
+
+  const calorimeter_clustering & gamma_sequence_builder::get_clustering() const
+  {
+    return _clustering_;
+  }
+
+  size_t gamma_sequence_builder::build_clustered(const channel_type * channels_,
+                                                 const double * times_,
+                                                 size_t nhits_,
+                                                 gamma_dict_type & clustered_gammas_)
+  {
+    size_t number_of_clusters = 0;
+    build_clustered(channels_, times_, nhits_, &_time_gap_, 1, &clustered_gammas_, &number_of_clusters);
+    return number_of_clusters;
+  }
+
+  void gamma_sequence_builder::build_clustered(const channel_type * channels_,
+                                               const double * times_,
+                                               size_t nhits_,
+                                               const double * gaps_,
+                                               size_t ngaps_,
+                                               gamma_dict_type * clustered_gammas_,
+                                               size_t * nclusters_)
+  {
+    _clustering_.process(channels_, nhits_);
+
+    const size_t number_of_clusters = _clustering_.get_number_of_clusters();
+
+    // Every hit sharing its channel with a cluster member belongs to the
+    // cluster; hits of unknown blocks are clusters of their own
+    const size_t nchannels = _channel_clusters_.size();
+    _hit_clusters_.resize(nhits_);
+    for (size_t icluster = 0; icluster < number_of_clusters; icluster++) {
+      for (const calorimeter_clustering::hit_index_type * ihit = _clustering_.cluster_begin(icluster);
+           ihit != _clustering_.cluster_end(icluster); ihit++) {
+        const channel_type a_channel = channels_[*ihit];
+        if (a_channel < nchannels) _channel_clusters_[a_channel] = icluster;
+        else _hit_clusters_[*ihit] = icluster;
+      }
+    }
+    for (size_t ihit = 0; ihit < nhits_; ihit++) {
+      const channel_type a_channel = channels_[ihit];
+      if (a_channel < nchannels) _hit_clusters_[ihit] = _channel_clusters_[a_channel];
+    }
+
+    // Hits are laid out cluster by cluster (counting sort on the cluster
+    // number), then time ordered within their cluster; hits sharing a time
+    // are all kept, ordered by channel
+    _cluster_offsets_.assign(number_of_clusters + 1, 0);
+    for (size_t ihit = 0; ihit < nhits_; ihit++) _cluster_offsets_[_hit_clusters_[ihit] + 1]++;
+    for (size_t icluster = 0; icluster < number_of_clusters; icluster++) {
+      _cluster_offsets_[icluster + 1] += _cluster_offsets_[icluster];
+    }
+    _ordered_hits_.resize(nhits_);
+    _cluster_order_.assign(_cluster_offsets_.begin(), _cluster_offsets_.end() - 1);
+    for (size_t ihit = 0; ihit < nhits_; ihit++) {
+      ordered_hit_type & an_ordered_hit = _ordered_hits_[_cluster_order_[_hit_clusters_[ihit]]++];
+      an_ordered_hit.time = times_[ihit];
+      an_ordered_hit.channel = channels_[ihit];
+    }
+    for (size_t icluster = 0; icluster < number_of_clusters; icluster++) {
+      std::sort(_ordered_hits_.begin() + _cluster_offsets_[icluster],
+                _ordered_hits_.begin() + _cluster_offsets_[icluster + 1]);
+    }
+
+    // Clusters are numbered in the lexicographical order of their time
+    // ordered hits
+    _cluster_order_.resize(number_of_clusters);
+    for (size_t icluster = 0; icluster < number_of_clusters; icluster++) _cluster_order_[icluster] = icluster;
+    std::sort(_cluster_order_.begin(), _cluster_order_.end(),
+              [this] (uint32_t left_, uint32_t right_) {
+                return std::lexicographical_compare(_ordered_hits_.begin() + _cluster_offsets_[left_],
+                                                    _ordered_hits_.begin() + _cluster_offsets_[left_ + 1],
+                                                    _ordered_hits_.begin() + _cluster_offsets_[right_],
+                                                    _ordered_hits_.begin() + _cluster_offsets_[right_ + 1]);
+              });
+
+    _gap_track_ids_.assign(ngaps_, 0);
+    std::fill(nclusters_, nclusters_ + ngaps_, number_of_clusters);
+
+    // Clusters are split in a single scan of their hits
+    for (const auto icluster : _cluster_order_)
+      {
+        for (size_t igap = 0; igap < ngaps_; igap++) _gap_track_ids_[igap]++;
+
+        double t0 = 0; // not ideal
+        double t1 = 0;
+
+        for (uint32_t ihit = _cluster_offsets_[icluster]; ihit < _cluster_offsets_[icluster + 1]; ihit++)
+          {
+            t0 = t1;
+            t1 = _ordered_hits_[ihit].time;
+
+            // The time difference is shared by all the gaps
+            const bool splittable = t0!=0 && t1!=0;
+            for (size_t igap = 0; igap < ngaps_; igap++)
+              {
+                if(splittable && t1-t0 > gaps_[igap] /*ns*/)
+                  {
+                    nclusters_[igap]++;
+                    _gap_track_ids_[igap]++;
+                  }
+
+                // An unknown block has no channel to be listed, its sequence is left empty
+                calo_list_type & a_list = clustered_gammas_[igap][_gap_track_ids_[igap]];
+                if (_ordered_hits_[ihit].channel < nchannels) a_list.insert(_ordered_hits_[ihit].channel);
+              }
+          }
+      }
+
+    return;
+  }
+
+  gamma_sequence_builder::simulated_status
+  gamma_sequence_builder::build_simulated(const channel_type * calibrated_channels_,
+                                          size_t ncalibrated_,
+                                          const channel_type * step_channels_,
+                                          const int * step_track_ids_,
+                                          size_t nsteps_,
+                                          size_t number_of_primary_gammas_,
+                                          gamma_dict_type & simulated_gammas_,
+                                          size_t & nattributed_)
+  {
+    nattributed_ = 0;
+    if (ncalibrated_ == 0) return NO_CALIBRATED_HITS;
+    if (nsteps_ == 0) return NO_STEP_HITS;
+
+    // Flag calibrated channels, flags left by the previous event are cleaned first
+    for (auto ichannel : _touched_channels_) _channel_flags_[ichannel] = 0;
+    _touched_channels_.clear();
+    for (size_t icalo = 0; icalo < ncalibrated_; icalo++) {
+      const channel_type a_channel = calibrated_channels_[icalo];
+      if (a_channel == calorimeter_channel_index::INVALID_CHANNEL) continue;
+      _channel_flags_[a_channel] = CHANNEL_CALIBRATED;
+      _touched_channels_.push_back(a_channel);
+    }
+
+    for (size_t ihit = 0; ihit < nsteps_; ihit++) {
+      const int track_id = step_track_ids_[ihit];
+      DT_THROW_IF(track_id == -1, std::logic_error, "Missing primary track id !");
+      if (track_id == 0) continue; // From a primary particles
+
+      // Check if calorimeter has been calibrated
+      const channel_type a_channel = step_channels_[ihit];
+      if (a_channel == calorimeter_channel_index::INVALID_CHANNEL) continue;
+      if (! (_channel_flags_[a_channel] & CHANNEL_CALIBRATED)) continue;
+
+      // Gid already attributed to a gamma
+      if (_channel_flags_[a_channel] & CHANNEL_ATTRIBUTED) continue;
+
+      // Not from a primary particles // Hack : removes around 10% of the stat
+      if (track_id > (int)number_of_primary_gammas_ + 1) return SECONDARY_PARTICLE;
+
+      _channel_flags_[a_channel] |= CHANNEL_ATTRIBUTED;
+
+      simulated_gammas_[track_id].insert(a_channel);
+      nattributed_++;
+    }
+
+    return SIMULATED_OK;
+  }
+
+  size_t gamma_sequence_builder::build_reconstructed(const channel_type * channels_,
+                                                     const uint32_t * hit_gammas_,
+                                                     const int * gamma_track_ids_,
+                                                     size_t nhits_,
+                                                     gamma_dict_type & reconstructed_gammas_)
+  {
+    size_t nunknown = 0;
+    for (size_t ihit = 0; ihit < nhits_; ihit++) {
+      const channel_type a_channel = channels_[ihit];
+      if (a_channel == calorimeter_channel_index::INVALID_CHANNEL) {
+        nunknown++;
+        continue;
+      }
+      reconstructed_gammas_[gamma_track_ids_[hit_gammas_[ihit]]].insert(a_channel);
+    }
+    return nunknown;
+  }
+
+} // namespace analysis
+
+// end of gamma_sequence_builder.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
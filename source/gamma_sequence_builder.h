@@ -0,0 +1,169 @@
+/* gamma_sequence_builder.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Build the calorimeter sequences of gammas from flat hit arrays:
+ *  - clustered sequences (no gamma tracking): neighbouring hits are
+ *    clustered and laid out in a flat array ordered by cluster and time,
+ *    then clusters are split where consecutive hit times differ by more
+ *    than a time gap (several gaps may be scanned at once); a hit without
+ *    channel (unknown block) is a cluster of its own, with an empty list,
+ *  - simulated sequences: calibrated calorimeters attributed to the first
+ *    primary track depositing energy in them,
+ *  - reconstructed sequences: calorimeters associated to each gamma.
+ * Shared by the module and the replay program so that both build the same
+ * sequences. Working space is kept from one event to the other.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_GAMMA_SEQUENCE_BUILDER_H_
+#define ANALYSIS_GAMMA_SEQUENCE_BUILDER_H_ 1
+
+// Standard libraries:
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// This project:
+#include <calorimeter_clustering.h>
+#include <gamma_sequence_matcher.h>
+
+namespace analysis {
+
+  class gamma_sequence_builder
+  {
+  public:
+
+    /// Typedef for calorimeter channel
+    typedef gamma_sequence_matcher::channel_type channel_type;
+
+    /// Typedef for gamma dictionnaries
+    typedef gamma_sequence_matcher::gamma_dict_type gamma_dict_type;
+
+    /// Typedef for calorimeters collection
+    typedef gamma_sequence_matcher::calo_list_type calo_list_type;
+
+    /// Default time gap splitting clusters (ns)
+    static const double DEFAULT_TIME_GAP;
+
+    /// Outcome of the simulated sequences building
+    enum simulated_status {
+      SIMULATED_OK       = 0, //!< Sequences are built
+      NO_CALIBRATED_HITS = 1, //!< No calibrated calorimeter
+      NO_STEP_HITS       = 2, //!< No simulated calorimeter hit
+      SECONDARY_PARTICLE = 3  //!< A calorimeter is first hit by a secondary particle
+    };
+
+    /// Constructor
+    gamma_sequence_builder();
+
+    /// Set the calorimeter neighbourhood
+    void initialize(size_t nchannels_,
+                    const uint32_t * offsets_,
+                    const channel_type * neighbours_,
+                    bool transitive_);
+
+    /// Return the time gap splitting clusters (ns)
+    double get_time_gap() const;
+
+    /// Set the time gap splitting clusters (ns)
+    void set_time_gap(double gap_);
+
+    /// Return the clustering engine, as left by the last clustered sequences
+    const calorimeter_clustering & get_clustering() const;
+
+    /// Build the clustered sequences of hits and return their number
+    size_t build_clustered(const channel_type * channels_,
+                           const double * times_,
+                           size_t nhits_,
+                           gamma_dict_type & gammas_);
+
+    /// Build the clustered sequences of hits for several time gaps at once:
+    /// neighbouring hits are clustered and time ordered once, then split for
+    /// every gap in the same pass ('gammas_' and 'nclusters_' have one entry per gap)
+    void build_clustered(const channel_type * channels_,
+                         const double * times_,
+                         size_t nhits_,
+                         const double * gaps_,
+                         size_t ngaps_,
+                         gamma_dict_type * gammas_,
+                         size_t * nclusters_);
+
+    /// Build the simulated sequences from the calibrated calorimeters and the
+    /// primary track ids of simulated hits (stops on the first secondary particle)
+    simulated_status build_simulated(const channel_type * calibrated_channels_,
+                                     size_t ncalibrated_,
+                                     const channel_type * step_channels_,
+                                     const int * step_track_ids_,
+                                     size_t nsteps_,
+                                     size_t number_of_primary_gammas_,
+                                     gamma_dict_type & gammas_,
+                                     size_t & nattributed_);
+
+    /// Build the reconstructed sequences and return the number of hits with unknown channel
+    size_t build_reconstructed(const channel_type * channels_,
+                               const uint32_t * hit_gammas_,
+                               const int * gamma_track_ids_,
+                               size_t nhits_,
+                               gamma_dict_type & gammas_);
+
+  private:
+
+    /// Hit of a time ordered cluster
+    struct ordered_hit_type {
+      double time;          //!< Time
+      channel_type channel; //!< Channel
+
+      /// Time, then channel ordering
+      bool operator<(const ordered_hit_type & other_) const
+      {
+        return time < other_.time || (time == other_.time && channel < other_.channel);
+      }
+    };
+
+    calorimeter_clustering _clustering_; //!< Clustering engine
+    double _time_gap_;                   //!< Time gap splitting clusters
+
+    // Working space, kept from one event to the other:
+    std::vector<uint32_t>     _channel_clusters_; //!< Cluster number per channel
+    std::vector<uint32_t>     _hit_clusters_;     //!< Cluster number per hit
+    std::vector<uint8_t>      _channel_flags_;    //!< Flags per channel
+    std::vector<channel_type> _touched_channels_; //!< Channels with flags to be cleaned
+    std::vector<int>          _gap_track_ids_;    //!< Current clustered track id per time gap
+    std::vector<uint32_t>     _cluster_offsets_;  //!< First ordered hit of each cluster (size = number of clusters + 1)
+    std::vector<uint32_t>     _cluster_order_;    //!< Clusters in numbering order
+    std::vector<ordered_hit_type> _ordered_hits_; //!< Hits ordered by cluster and time
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_GAMMA_SEQUENCE_BUILDER_H_
+
+// end of gamma_sequence_builder.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
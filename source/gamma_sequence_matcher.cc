@@ -0,0 +1,202 @@
+// gamma_sequence_matcher.cc
+
+// Ourselves:
+#include <gamma_sequence_matcher.h>
+
+namespace analysis {
+
+  namespace {
+
+    // 64 bits mixing function (splitmix64 finalizer)
+    uint64_t mix_fingerprint(uint64_t value_)
+    {
+      value_ = (value_ ^ (value_ >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      value_ = (value_ ^ (value_ >> 27)) * 0x94d049bb133111ebULL;
+      return value_ ^ (value_ >> 31);
+    }
+
+    // Fingerprint of a calorimeter sequence, channels are visited in increasing order
+    template <class List>
+    uint64_t sequence_fingerprint(const List & list_)
+    {
+      uint64_t a_fingerprint = list_.size();
+      for (auto ichannel : list_) {
+        a_fingerprint = mix_fingerprint(a_fingerprint ^ (ichannel + 0x9e3779b97f4a7c15ULL));
+      }
+      return a_fingerprint;
+    }
+
+#ifdef ANALYSIS_BITSET_CALO_LIST
+    // Fingerprint of a calorimeter bitset, computed from its storage words
+    uint64_t sequence_fingerprint(const calorimeter_bitset & list_)
+    {
+      uint64_t a_fingerprint = list_.size();
+      const calorimeter_bitset::word_type * the_words = list_.get_words();
+      for (size_t i = 0; i < calorimeter_bitset::NUMBER_OF_WORDS; i++) {
+        if (the_words[i] == 0) continue;
+        a_fingerprint = mix_fingerprint(a_fingerprint ^ mix_fingerprint(the_words[i] + i));
+      }
+      return a_fingerprint;
+    }
+#endif
+
+    // Number of channels shared by 2 sequences, channels are visited in increasing order
+    template <class List>
+    size_t count_common(const List & first_, const List & second_)
+    {
+      size_t ncommon = 0;
+      auto ifirst = first_.begin();
+      auto isecond = second_.begin();
+      while (ifirst != first_.end() && isecond != second_.end()) {
+        if (*ifirst < *isecond) ifirst++;
+        else if (*isecond < *ifirst) isecond++;
+        else {
+          ncommon++;
+          ifirst++;
+          isecond++;
+        }
+      }
+      return ncommon;
+    }
+
+#ifdef ANALYSIS_BITSET_CALO_LIST
+    // Number of channels shared by 2 calorimeter bitsets
+    size_t count_common(const calorimeter_bitset & first_, const calorimeter_bitset & second_)
+    {
+      return first_.count_common(second_);
+    }
+#endif
+
+  }
+
+  const char * gamma_sequence_matcher::get_mismatch_kind_name(mismatch_kind kind_)
+  {
+    switch (kind_) {
+    case SPLIT:           return "split";
+    case MERGE:           return "merge";
+    case MISSING_CALO:    return "missing_calo";
+    case EXTRA_CALO:      return "extra_calo";
+    case UNMATCHED_GAMMA: return "unmatched_gamma";
+    default:              return "";
+    }
+  }
+
+  uint64_t gamma_sequence_matcher::fingerprint(const calo_list_type & list_)
+  {
+    return sequence_fingerprint(list_);
+  }
+
+  gamma_sequence_matcher::gamma_sequence_matcher()
+  {
+    return;
+  }
+
+  size_t gamma_sequence_matcher::count_identical(const gamma_dict_type & simulated_gammas_,
+                                                 const gamma_dict_type & reconstructed_gammas_)
+  {
+    size_t a_size = 8;
+    while (a_size < 2 * simulated_gammas_.size()) a_size <<= 1;
+    const size_t a_mask = a_size - 1;
+    _slots_.assign(a_size, -1);
+    _entries_.clear();
+    for (const auto & isim : simulated_gammas_) {
+      const uint64_t a_fingerprint = fingerprint(isim.second);
+      size_t a_slot = a_fingerprint & a_mask;
+      while (_slots_[a_slot] != -1) a_slot = (a_slot + 1) & a_mask;
+      _slots_[a_slot] = _entries_.size();
+      _entries_.push_back(std::make_pair(a_fingerprint, &isim.second));
+    }
+
+    size_t nidentical = 0;
+    for (const auto & irec : reconstructed_gammas_) {
+      const calo_list_type & a_rec_list = irec.second;
+      const uint64_t a_fingerprint = fingerprint(a_rec_list);
+      for (size_t a_slot = a_fingerprint & a_mask; _slots_[a_slot] != -1; a_slot = (a_slot + 1) & a_mask) {
+        const auto & an_entry = _entries_[_slots_[a_slot]];
+        if (an_entry.first != a_fingerprint || *an_entry.second != a_rec_list) continue;
+        nidentical++;
+        break;
+      }
+    }
+    return nidentical;
+  }
+
+  void gamma_sequence_matcher::match(const gamma_dict_type & simulated_gammas_,
+                                     const gamma_dict_type & reconstructed_gammas_,
+                                     match_type & match_)
+  {
+    match_.nidentical = count_identical(simulated_gammas_, reconstructed_gammas_);
+    for (size_t i = 0; i < NUMBER_OF_MISMATCH_KINDS; i++) match_.kinds[i] = 0;
+    const size_t nsimulated = simulated_gammas_.size();
+    const size_t nreconstructed = reconstructed_gammas_.size();
+    if (match_.nidentical == nsimulated && match_.nidentical == nreconstructed) return;
+
+    // Shared calorimeters of every simulated and reconstructed pair, the
+    // simulated sequences are those of the fingerprint table
+    _reconstructed_lists_.clear();
+    for (const auto & irec : reconstructed_gammas_) _reconstructed_lists_.push_back(&irec.second);
+    _overlaps_.assign(nsimulated * nreconstructed, 0);
+    for (size_t isim = 0; isim < nsimulated; isim++) {
+      for (size_t irec = 0; irec < nreconstructed; irec++) {
+        _overlaps_[isim * nreconstructed + irec] = count_common(*_entries_[isim].second, *_reconstructed_lists_[irec]);
+      }
+    }
+
+    // Simulated gammas side: missed or split
+    for (size_t isim = 0; isim < nsimulated; isim++) {
+      const size_t a_size = _entries_[isim].second->size();
+      size_t noverlapping = 0;
+      bool identical = false;
+      for (size_t irec = 0; irec < nreconstructed; irec++) {
+        const size_t ncommon = _overlaps_[isim * nreconstructed + irec];
+        if (ncommon == 0) continue;
+        noverlapping++;
+        if (ncommon == a_size && ncommon == _reconstructed_lists_[irec]->size()) identical = true;
+      }
+      if (identical) continue;
+      if (noverlapping == 0) match_.kinds[UNMATCHED_GAMMA]++;
+      else if (noverlapping > 1) match_.kinds[SPLIT]++;
+    }
+
+    // Reconstructed sequences side: fake, merged, incomplete or overgrown
+    for (size_t irec = 0; irec < nreconstructed; irec++) {
+      const size_t a_size = _reconstructed_lists_[irec]->size();
+      size_t noverlapping = 0;
+      size_t a_simulated = 0;
+      for (size_t isim = 0; isim < nsimulated; isim++) {
+        if (_overlaps_[isim * nreconstructed + irec] == 0) continue;
+        noverlapping++;
+        a_simulated = isim;
+      }
+      if (noverlapping == 0) {
+        match_.kinds[UNMATCHED_GAMMA]++;
+        continue;
+      }
+      if (noverlapping > 1) {
+        match_.kinds[MERGE]++;
+        continue;
+      }
+      const size_t ncommon = _overlaps_[a_simulated * nreconstructed + irec];
+      const size_t a_simulated_size = _entries_[a_simulated].second->size();
+      if (ncommon == a_size && ncommon == a_simulated_size) continue;
+      // Calorimeters of a split gamma are accounted for by the split
+      size_t nsiblings = 0;
+      for (size_t jrec = 0; jrec < nreconstructed; jrec++) {
+        if (_overlaps_[a_simulated * nreconstructed + jrec] > 0) nsiblings++;
+      }
+      if (nsiblings == 1 && ncommon < a_simulated_size) match_.kinds[MISSING_CALO]++;
+      if (ncommon < a_size) match_.kinds[EXTRA_CALO]++;
+    }
+    return;
+  }
+
+} // namespace analysis
+
+// end of gamma_sequence_matcher.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
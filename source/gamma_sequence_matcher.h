@@ -0,0 +1,123 @@
+/* gamma_sequence_matcher.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Calorimeter sequences of gammas and their matching. Each sequence gets
+ * a 64 bits fingerprint; simulated sequences are stored in an open
+ * addressing table and every reconstructed sequence is fully compared only
+ * to the simulated ones sharing its fingerprint. When sequences differ,
+ * the number of calorimeters shared by each simulated and reconstructed
+ * pair tells split, merged, incomplete, overgrown or unmatched gammas.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_GAMMA_SEQUENCE_MATCHER_H_
+#define ANALYSIS_GAMMA_SEQUENCE_MATCHER_H_ 1
+
+// Standard libraries:
+#include <set>
+#include <map>
+#include <vector>
+#include <cstdint>
+
+// This project:
+#include <calorimeter_channel_index.h>
+#include <calorimeter_bitset.h>
+#include <event_arena.h>
+
+namespace analysis {
+
+  class gamma_sequence_matcher
+  {
+  public:
+
+    /// Typedef for calorimeter channel
+    typedef calorimeter_channel_index::channel_type channel_type;
+
+    /// Typedef for calorimeters collection
+#ifdef ANALYSIS_BITSET_CALO_LIST
+    typedef calorimeter_bitset calo_list_type;
+#else
+    typedef std::set<channel_type, std::less<channel_type>, arena_allocator<channel_type> > calo_list_type;
+#endif
+
+    /// Typedef for gamma dictionnaries
+    typedef std::map<int, calo_list_type, std::less<int>,
+                     arena_allocator<std::pair<const int, calo_list_type> > > gamma_dict_type;
+
+    /// Kinds of differences between simulated and reconstructed sequences
+    enum mismatch_kind {
+      SPLIT           = 0, //!< Simulated gamma spread over several sequences
+      MERGE           = 1, //!< Sequence gathering several simulated gammas
+      MISSING_CALO    = 2, //!< Sequence lacking calorimeters of its simulated gamma
+      EXTRA_CALO      = 3, //!< Sequence with calorimeters foreign to its simulated gamma
+      UNMATCHED_GAMMA = 4, //!< Simulated gamma or sequence sharing no calorimeter with the other side
+      NUMBER_OF_MISMATCH_KINDS = 5
+    };
+
+    /// Matching of the sequences of an event
+    struct match_type {
+      size_t nidentical; //!< Number of identical sequences
+      size_t kinds[NUMBER_OF_MISMATCH_KINDS]; //!< Number of differences per kind
+    };
+
+    /// Return the name of a kind of difference
+    static const char * get_mismatch_kind_name(mismatch_kind kind_);
+
+    /// Return the fingerprint of a sequence
+    static uint64_t fingerprint(const calo_list_type & list_);
+
+    /// Constructor
+    gamma_sequence_matcher();
+
+    /// Count the reconstructed sequences identical to one of the simulated sequences
+    size_t count_identical(const gamma_dict_type & simulated_gammas_,
+                           const gamma_dict_type & reconstructed_gammas_);
+
+    /// Count the identical sequences and classify the differences of the
+    /// other ones from the calorimeters they share
+    void match(const gamma_dict_type & simulated_gammas_,
+               const gamma_dict_type & reconstructed_gammas_,
+               match_type & match_);
+
+  private:
+
+    // Working space, kept from one event to the other:
+    std::vector<int32_t> _slots_; //!< Hash table of simulated sequences
+    std::vector<std::pair<uint64_t, const calo_list_type *> > _entries_; //!< Simulated sequences fingerprints
+    std::vector<uint32_t> _overlaps_; //!< Number of shared calorimeters per simulated and reconstructed sequences
+    std::vector<const calo_list_type *> _reconstructed_lists_; //!< Reconstructed sequences
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_GAMMA_SEQUENCE_MATCHER_H_
+
+// end of gamma_sequence_matcher.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
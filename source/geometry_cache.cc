@@ -0,0 +1,281 @@
+// geometry_cache.cc
+
+// Ourselves:
+#include <geometry_cache.h>
+
+// Standard library:
+#include <fstream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+// - POSIX:
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+namespace analysis {
+
+  namespace {
+
+    const char MAGIC[8] = {'S', 'N', 'G', 'T', 'G', 'E', 'O', 'M'};
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    template <class T>
+    void write_value(std::ofstream & file_, const T & value_)
+    {
+      file_.write(reinterpret_cast<const char *>(&value_), sizeof(T));
+    }
+
+    template <class T>
+    void write_column(std::ofstream & file_, const std::vector<T> & column_)
+    {
+      file_.write(reinterpret_cast<const char *>(column_.data()), column_.size() * sizeof(T));
+    }
+
+    /// Read only memory mapping of a whole file
+    class mapped_file
+    {
+    public:
+
+      mapped_file(const std::string & filename_)
+      {
+        _data_ = 0;
+        _size_ = 0;
+        _position_ = 0;
+        const int fd = ::open(filename_.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat a_stat;
+        if (::fstat(fd, &a_stat) == 0 && a_stat.st_size > 0) {
+          void * an_address = ::mmap(0, a_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+          if (an_address != MAP_FAILED) {
+            _data_ = static_cast<const char *>(an_address);
+            _size_ = a_stat.st_size;
+          }
+        }
+        ::close(fd);
+        return;
+      }
+
+      ~mapped_file()
+      {
+        if (_data_) ::munmap(const_cast<char *>(_data_), _size_);
+        return;
+      }
+
+      bool is_mapped() const
+      {
+        return _data_ != 0;
+      }
+
+      /// Return the number of bytes left to read
+      size_t get_remaining() const
+      {
+        return _size_ - _position_;
+      }
+
+      /// Copy the next bytes, return false past the end of the file
+      bool read(void * destination_, size_t nbytes_)
+      {
+        if (nbytes_ > get_remaining()) return false;
+        std::memcpy(destination_, _data_ + _position_, nbytes_);
+        _position_ += nbytes_;
+        return true;
+      }
+
+      template <class T>
+      bool read_value(T & value_)
+      {
+        return read(&value_, sizeof(T));
+      }
+
+      template <class T>
+      bool read_column(std::vector<T> & column_, size_t size_)
+      {
+        if (size_ > get_remaining() / sizeof(T)) return false;
+        column_.resize(size_);
+        return read(column_.data(), size_ * sizeof(T));
+      }
+
+      bool read_string(std::string & value_, size_t size_)
+      {
+        if (size_ > get_remaining()) return false;
+        value_.assign(_data_ + _position_, size_);
+        _position_ += size_;
+        return true;
+      }
+
+    private:
+
+      mapped_file(const mapped_file &);
+      mapped_file & operator=(const mapped_file &);
+
+      const char * _data_; //!< Mapped file content
+      size_t _size_;       //!< File size
+      size_t _position_;   //!< Reading position
+    };
+
+  }
+
+  const uint32_t geometry_cache::VERSION;
+
+  geometry_cache::geometry_cache()
+  {
+    return;
+  }
+
+  void geometry_cache::set_setup(const std::string & label_, const std::string & version_)
+  {
+    _setup_label_ = label_;
+    _setup_version_ = version_;
+    return;
+  }
+
+  const std::string & geometry_cache::get_setup_label() const
+  {
+    return _setup_label_;
+  }
+
+  const std::string & geometry_cache::get_setup_version() const
+  {
+    return _setup_version_;
+  }
+
+  bool geometry_cache::load(const std::string & filename_,
+                            calorimeter_channel_index & channels_,
+                            calorimeter_adjacency & adjacency_) const
+  {
+    mapped_file a_file(filename_);
+    if (! a_file.is_mapped()) return false;
+
+    char a_magic[sizeof(MAGIC)];
+    if (! a_file.read(a_magic, sizeof(a_magic)) || std::memcmp(a_magic, MAGIC, sizeof(MAGIC)) != 0) return false;
+    uint32_t a_version = 0;
+    uint32_t a_byte_order_mark = 0;
+    uint32_t a_label_size = 0;
+    uint32_t a_version_size = 0;
+    uint32_t nchannels = 0;
+    uint32_t naddresses = 0;
+    uint32_t nneighbours = 0;
+    if (! a_file.read_value(a_version) || a_version != VERSION) return false;
+    if (! a_file.read_value(a_byte_order_mark) || a_byte_order_mark != BYTE_ORDER_MARK) return false;
+    if (! a_file.read_value(a_label_size)
+        || ! a_file.read_value(a_version_size)
+        || ! a_file.read_value(nchannels)
+        || ! a_file.read_value(naddresses)
+        || ! a_file.read_value(nneighbours)) return false;
+
+    std::string a_setup_label;
+    std::string a_setup_version;
+    if (! a_file.read_string(a_setup_label, a_label_size)
+        || ! a_file.read_string(a_setup_version, a_version_size)) return false;
+    if (a_setup_label != _setup_label_ || a_setup_version != _setup_version_) return false;
+    if (nchannels == 0 || nchannels > calorimeter_channel_index::INVALID_CHANNEL) return false;
+
+    std::vector<uint32_t> the_types;
+    std::vector<uint32_t> the_address_offsets;
+    std::vector<uint32_t> the_addresses;
+    std::vector<uint32_t> the_offsets;
+    std::vector<calorimeter_adjacency::channel_type> the_neighbours;
+    if (! a_file.read_column(the_types, nchannels)
+        || ! a_file.read_column(the_address_offsets, nchannels + 1)
+        || ! a_file.read_column(the_addresses, naddresses)
+        || ! a_file.read_column(the_offsets, nchannels + 1)
+        || ! a_file.read_column(the_neighbours, nneighbours)
+        || a_file.get_remaining() != 0) return false;
+    if (the_address_offsets.front() != 0 || the_address_offsets.back() != naddresses) return false;
+
+    std::vector<geomtools::geom_id> the_gids(nchannels);
+    for (size_t ichannel = 0; ichannel < nchannels; ichannel++) {
+      const uint32_t a_begin = the_address_offsets[ichannel];
+      const uint32_t an_end = the_address_offsets[ichannel + 1];
+      if (a_begin > an_end) return false;
+      geomtools::geom_id & a_gid = the_gids[ichannel];
+      a_gid.set_type(the_types[ichannel]);
+      a_gid.set_depth(an_end - a_begin);
+      for (uint32_t iaddress = a_begin; iaddress < an_end; iaddress++) {
+        a_gid.set(iaddress - a_begin, the_addresses[iaddress]);
+      }
+    }
+
+    // The tables check their own consistency
+    try {
+      channels_.reset();
+      adjacency_.reset();
+      channels_.initialize(the_gids);
+      adjacency_.initialize(the_offsets, the_neighbours);
+    } catch (std::exception &) {
+      channels_.reset();
+      adjacency_.reset();
+      return false;
+    }
+    if (adjacency_.get_number_of_channels() != channels_.size()) {
+      channels_.reset();
+      adjacency_.reset();
+      return false;
+    }
+    return true;
+  }
+
+  void geometry_cache::store(const std::string & filename_,
+                             const calorimeter_channel_index & channels_,
+                             const calorimeter_adjacency & adjacency_) const
+  {
+    DT_THROW_IF(! channels_.is_initialized() || ! adjacency_.is_initialized(), std::logic_error,
+                "Calorimeter channels and adjacency must be initialized to be cached !");
+    DT_THROW_IF(adjacency_.get_number_of_channels() != channels_.size(), std::logic_error,
+                "Calorimeter channels and adjacency do not match !");
+
+    std::vector<uint32_t> the_types;
+    std::vector<uint32_t> the_address_offsets(1, 0);
+    std::vector<uint32_t> the_addresses;
+    for (const auto & igid : channels_.get_geom_ids()) {
+      the_types.push_back(igid.get_type());
+      for (size_t iaddress = 0; iaddress < igid.get_depth(); iaddress++) {
+        the_addresses.push_back(igid.get(iaddress));
+      }
+      the_address_offsets.push_back(the_addresses.size());
+    }
+
+    const std::string a_tmp_filename = filename_ + ".tmp";
+    {
+      std::ofstream out(a_tmp_filename.c_str(), std::ios::binary | std::ios::trunc);
+      DT_THROW_IF(! out, std::runtime_error, "Cannot open geometry cache file '" << a_tmp_filename << "' !");
+      out.write(MAGIC, sizeof(MAGIC));
+      write_value(out, VERSION);
+      write_value(out, BYTE_ORDER_MARK);
+      write_value(out, static_cast<uint32_t>(_setup_label_.size()));
+      write_value(out, static_cast<uint32_t>(_setup_version_.size()));
+      write_value(out, static_cast<uint32_t>(channels_.size()));
+      write_value(out, static_cast<uint32_t>(the_addresses.size()));
+      write_value(out, static_cast<uint32_t>(adjacency_.get_neighbours().size()));
+      out.write(_setup_label_.data(), _setup_label_.size());
+      out.write(_setup_version_.data(), _setup_version_.size());
+      write_column(out, the_types);
+      write_column(out, the_address_offsets);
+      write_column(out, the_addresses);
+      write_column(out, adjacency_.get_offsets());
+      write_column(out, adjacency_.get_neighbours());
+      out.flush();
+      DT_THROW_IF(! out, std::runtime_error, "Cannot write geometry cache file '" << a_tmp_filename << "' !");
+    }
+    DT_THROW_IF(std::rename(a_tmp_filename.c_str(), filename_.c_str()) != 0, std::runtime_error,
+                "Cannot rename geometry cache file '" << a_tmp_filename << "' to '" << filename_ << "' !");
+    return;
+  }
+
+} // namespace analysis
+
+// end of geometry_cache.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
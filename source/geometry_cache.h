@@ -0,0 +1,106 @@
+/* geometry_cache.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Binary file holding what the module takes from the geometry i.e. the
+ * calorimeter channels and their first neighbours, so that later jobs can
+ * skip the geometry service. The file is keyed by the geometry setup label
+ * and version it has been built from and is memory mapped when loaded:
+ *
+ *   header     : magic "SNGTGEOM", uint32 version, uint32 byte order mark
+ *                (0x01020304 in host order), uint32 setup label length,
+ *                uint32 setup version length, uint32 number of channels,
+ *                uint32 number of geometry id addresses, uint32 number of
+ *                neighbours, then the setup label and version characters
+ *   channels   : uint32 geom_id_types[nchannels]
+ *                uint32 address_offsets[nchannels + 1]
+ *                uint32 addresses[naddresses]
+ *   neighbours : uint32 offsets[nchannels + 1]
+ *                uint16 neighbours[nneighbours]
+ *
+ * Values are stored in host byte order, without padding. A file which is
+ * missing, truncated, of another version or byte order, or built from
+ * another geometry setup is not valid and must be rebuilt.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_GEOMETRY_CACHE_H_
+#define ANALYSIS_GEOMETRY_CACHE_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <cstdint>
+
+// This project:
+#include <calorimeter_channel_index.h>
+#include <calorimeter_adjacency.h>
+
+namespace analysis {
+
+  class geometry_cache
+  {
+  public:
+
+    /// Format version
+    static const uint32_t VERSION = 1;
+
+    /// Constructor
+    geometry_cache();
+
+    /// Set the geometry setup the cache is built from
+    void set_setup(const std::string & label_, const std::string & version_);
+
+    /// Return the geometry setup label
+    const std::string & get_setup_label() const;
+
+    /// Return the geometry setup version
+    const std::string & get_setup_version() const;
+
+    /// Load the channels and their neighbours, return false if the file is missing or not valid
+    bool load(const std::string & filename_,
+              calorimeter_channel_index & channels_,
+              calorimeter_adjacency & adjacency_) const;
+
+    /// Store the channels and their neighbours
+    void store(const std::string & filename_,
+               const calorimeter_channel_index & channels_,
+               const calorimeter_adjacency & adjacency_) const;
+
+  private:
+
+    std::string _setup_label_;   //!< Geometry setup label
+    std::string _setup_version_; //!< Geometry setup version
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_GEOMETRY_CACHE_H_
+
+// end of geometry_cache.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
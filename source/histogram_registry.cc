@@ -0,0 +1,168 @@
+// histogram_registry.cc
+
+// Ourselves:
+#include <histogram_registry.h>
+
+// Standard library:
+#include <vector>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+#include <datatools/properties.h>
+// - Bayeux/mygsl
+#include <mygsl/histogram_pool.h>
+
+namespace analysis {
+
+  namespace {
+
+    /// Histogram declaration
+    struct histogram_entry_type {
+      const char * name;     //!< Histogram name or family suffix
+      const char * group;    //!< Histogram group
+      const char * template_name; //!< Template histogram to mimic
+    };
+
+    const histogram_entry_type HISTOGRAMS[histogram_registry::NUMBER_OF_HISTOGRAMS] = {
+      {"number_of_gamma_calos",    "number_of_gamma_calos",    "number_of_calos_template"},
+      {"number_of_gamma_clusters", "number_of_gamma_clusters", "number_of_calos_template"},
+      {"clusters_size",            "clusters_size",            "number_of_calos_template"},
+      {"total_number_of_calos",    "number_of_calos",          "number_of_calos_template"},
+      {"number_of_gammas",         "number_of_calos",          "number_of_calos_template"},
+      {"total_gamma_energy",       "total_gamma_energy",       "energy_template"}
+    };
+
+    const histogram_entry_type FAMILIES[histogram_registry::NUMBER_OF_FAMILIES] = {
+      {"_gamma_energy_min", "gamma_energy_min", "energy_template"},
+      {"_gamma_energy_mid", "gamma_energy_mid", "energy_template"},
+      {"_gamma_energy_max", "gamma_energy_max", "energy_template"},
+      {"calos_delta_L_cluster",    "delta_L", "delta_L_template"},
+      {"calos_delta_Lnot_cluster", "delta_L", "delta_L_template"}
+    };
+
+    const char * TEMPLATES[] = {"number_of_calos_template", "energy_template", "delta_L_template"};
+
+  }
+
+  const size_t histogram_registry::CACHE_SIZE;
+
+  bool histogram_registry::is_template(const std::string & name_)
+  {
+    for (auto itemplate : TEMPLATES) {
+      if (name_ == itemplate) return true;
+    }
+    return false;
+  }
+
+  mygsl::histogram_1d & histogram_registry::grab(mygsl::histogram_pool & pool_,
+                                                 const std::string & name_,
+                                                 const std::string & group_,
+                                                 const std::string & template_)
+  {
+    if (! pool_.has(name_))
+      {
+        mygsl::histogram_1d & h = pool_.add_1d(name_, "", group_);
+        datatools::properties hconfig;
+        hconfig.store_string("mode", "mimic");
+        hconfig.store_string("mimic.histogram_1d", template_);
+        mygsl::histogram_pool::init_histo_1d(h, hconfig, &pool_);
+      }
+    return pool_.grab_1d(name_);
+  }
+
+  void histogram_registry::copy_templates(const mygsl::histogram_pool & from_,
+                                          mygsl::histogram_pool & to_)
+  {
+    for (auto itemplate : TEMPLATES) {
+      if (! from_.has_1d(itemplate)) continue;
+      mygsl::histogram_1d & h = to_.add_1d(itemplate, from_.get_title(itemplate), from_.get_group(itemplate));
+      h = from_.get_1d(itemplate);
+    }
+    return;
+  }
+
+  void histogram_registry::merge(const mygsl::histogram_pool & from_,
+                                 mygsl::histogram_pool & to_)
+  {
+    // Histograms are filled with unit weights so that bin contents are
+    // integers and summing them does not depend on the merging order
+    std::vector<std::string> the_names;
+    from_.names(the_names);
+    for (const auto & iname : the_names) {
+      if (is_template(iname) || ! from_.has_1d(iname)) continue;
+      const mygsl::histogram_1d & a_histo = from_.get_1d(iname);
+      if (! to_.has(iname))
+        {
+          mygsl::histogram_1d & h = to_.add_1d(iname, from_.get_title(iname), from_.get_group(iname));
+          h = a_histo;
+          continue;
+        }
+      to_.grab_1d(iname) += a_histo;
+    }
+    return;
+  }
+
+  histogram_registry::histogram_registry()
+  {
+    reset();
+    return;
+  }
+
+  bool histogram_registry::is_initialized() const
+  {
+    return _pool_ != 0;
+  }
+
+  void histogram_registry::initialize(mygsl::histogram_pool & pool_)
+  {
+    DT_THROW_IF(is_initialized(), std::logic_error, "Histogram registry is already initialized !");
+    _pool_ = &pool_;
+    for (size_t i = 0; i < NUMBER_OF_HISTOGRAMS; i++) {
+      const histogram_entry_type & an_entry = HISTOGRAMS[i];
+      _histograms_[i] = &grab(*_pool_, an_entry.name, an_entry.group, an_entry.template_name);
+    }
+    return;
+  }
+
+  void histogram_registry::reset()
+  {
+    _pool_ = 0;
+    for (size_t i = 0; i < NUMBER_OF_HISTOGRAMS; i++) {
+      _histograms_[i] = 0;
+    }
+    for (size_t i = 0; i < NUMBER_OF_FAMILIES; i++) {
+      for (size_t j = 0; j < CACHE_SIZE; j++) {
+        _cache_[i][j] = 0;
+      }
+    }
+    return;
+  }
+
+  mygsl::histogram_1d & histogram_registry::get(histogram_id id_) const
+  {
+    return *_histograms_[id_];
+  }
+
+  mygsl::histogram_1d & histogram_registry::get(family_id id_, unsigned int key_)
+  {
+    if (key_ < CACHE_SIZE && _cache_[id_][key_] != 0) return *_cache_[id_][key_];
+
+    const histogram_entry_type & an_entry = FAMILIES[id_];
+    mygsl::histogram_1d & h = grab(*_pool_, std::to_string(key_) + an_entry.name,
+                                   an_entry.group, an_entry.template_name);
+    if (key_ < CACHE_SIZE) _cache_[id_][key_] = &h;
+    return h;
+  }
+
+} // namespace analysis
+
+// end of histogram_registry.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
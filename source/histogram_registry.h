@@ -0,0 +1,128 @@
+/* histogram_registry.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Handles to the histograms filled by the gamma tracking efficiency
+ * module. Fixed histograms are created (if needed) and resolved once at
+ * initialization. Histograms of a family are named after an integer key
+ * (e.g. '3_gamma_energy_min') and resolved on first use through a bounded
+ * cache; keys out of the cache go back to the pool lookup.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_HISTOGRAM_REGISTRY_H_
+#define ANALYSIS_HISTOGRAM_REGISTRY_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <cstddef>
+
+namespace mygsl {
+  class histogram_1d;
+  class histogram_pool;
+}
+
+namespace analysis {
+
+  class histogram_registry
+  {
+  public:
+
+    /// Fixed histograms
+    enum histogram_id {
+      NUMBER_OF_GAMMA_CALOS    = 0,
+      NUMBER_OF_GAMMA_CLUSTERS = 1,
+      CLUSTERS_SIZE            = 2,
+      TOTAL_NUMBER_OF_CALOS    = 3,
+      NUMBER_OF_GAMMAS         = 4,
+      TOTAL_GAMMA_ENERGY       = 5,
+      NUMBER_OF_HISTOGRAMS     = 6
+    };
+
+    /// Histogram families
+    enum family_id {
+      GAMMA_ENERGY_MIN   = 0,
+      GAMMA_ENERGY_MID   = 1,
+      GAMMA_ENERGY_MAX   = 2,
+      DELTA_L_CLUSTER     = 3,
+      DELTA_L_NOT_CLUSTER = 4,
+      NUMBER_OF_FAMILIES = 5
+    };
+
+    /// Number of cached histograms per family
+    static const size_t CACHE_SIZE = 32;
+
+    /// Grab a histogram from a pool, creating it from a template if missing
+    static mygsl::histogram_1d & grab(mygsl::histogram_pool & pool_,
+                                      const std::string & name_,
+                                      const std::string & group_,
+                                      const std::string & template_);
+
+    /// Check if a histogram is one of the templates used by the registry
+    static bool is_template(const std::string & name_);
+
+    /// Copy the templates used by the registry from a pool to another
+    static void copy_templates(const mygsl::histogram_pool & from_,
+                               mygsl::histogram_pool & to_);
+
+    /// Add the histograms of a pool (templates excepted) to another one
+    static void merge(const mygsl::histogram_pool & from_,
+                      mygsl::histogram_pool & to_);
+
+    /// Constructor
+    histogram_registry();
+
+    /// Check initialization flag
+    bool is_initialized() const;
+
+    /// Resolve histograms from a pool
+    void initialize(mygsl::histogram_pool & pool_);
+
+    /// Reset
+    void reset();
+
+    /// Return a fixed histogram
+    mygsl::histogram_1d & get(histogram_id id_) const;
+
+    /// Return the histogram of a family for a given key
+    mygsl::histogram_1d & get(family_id id_, unsigned int key_);
+
+  private:
+
+    mygsl::histogram_pool * _pool_; //!< Histogram pool
+    mygsl::histogram_1d * _histograms_[NUMBER_OF_HISTOGRAMS];    //!< Fixed histograms
+    mygsl::histogram_1d * _cache_[NUMBER_OF_FAMILIES][CACHE_SIZE]; //!< Family histograms
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_HISTOGRAM_REGISTRY_H_
+
+// end of histogram_registry.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,314 @@
+// hit_table.cc
+
+// Ourselves:
+#include <hit_table.h>
+
+// Standard library:
+#include <cstring>
+#include <stdexcept>
+// - POSIX:
+#include <unistd.h>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+namespace analysis {
+
+  namespace {
+
+    const char MAGIC[8] = {'S', 'N', 'G', 'T', 'H', 'I', 'T', 'S'};
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+    const size_t BUFFER_SIZE = 1 << 20;
+
+    static_assert(sizeof(int) == sizeof(int32_t), "Track ids are stored as 32 bits integers");
+
+    template <class T>
+    void write_value(std::fstream & file_, const T & value_)
+    {
+      file_.write(reinterpret_cast<const char *>(&value_), sizeof(T));
+    }
+
+    template <class T>
+    void write_column(std::fstream & file_, const std::vector<T> & column_)
+    {
+      file_.write(reinterpret_cast<const char *>(column_.data()), column_.size() * sizeof(T));
+    }
+
+    template <class T>
+    void read_value(std::fstream & file_, T & value_)
+    {
+      file_.read(reinterpret_cast<char *>(&value_), sizeof(T));
+    }
+
+    template <class T>
+    void read_column(std::fstream & file_, std::vector<T> & column_, size_t size_)
+    {
+      column_.resize(size_);
+      file_.read(reinterpret_cast<char *>(column_.data()), size_ * sizeof(T));
+    }
+
+  }
+
+  const uint32_t hit_table::VERSION;
+  const uint32_t hit_table::NO_GAMMA;
+  const hit_table::channel_type hit_table::INVALID_CHANNEL;
+
+  void hit_table::event_type::clear()
+  {
+    run_number = -1;
+    event_number = -1;
+    flags = 0;
+    number_of_primary_gammas = 0;
+    number_of_calibrated_hits = 0;
+    number_of_step_hits = 0;
+    number_of_gamma_hits = 0;
+    gamma_track_ids.clear();
+    channels.clear();
+    hit_gammas.clear();
+    truth_track_ids.clear();
+    times.clear();
+    energies.clear();
+    return;
+  }
+
+  size_t hit_table::event_type::size() const
+  {
+    return channels.size();
+  }
+
+  void hit_table::event_type::push_back(channel_type channel_, uint32_t gamma_, int truth_track_id_,
+                                        double time_, double energy_)
+  {
+    channels.push_back(channel_);
+    hit_gammas.push_back(gamma_);
+    truth_track_ids.push_back(truth_track_id_);
+    times.push_back(time_);
+    energies.push_back(energy_);
+    return;
+  }
+
+  hit_table::hit_table()
+  {
+    _writing_ = false;
+    _number_of_events_ = 0;
+    return;
+  }
+
+  hit_table::~hit_table()
+  {
+    if (is_open()) close();
+    return;
+  }
+
+  bool hit_table::is_open() const
+  {
+    return _file_.is_open();
+  }
+
+  void hit_table::create(const std::string & filename_, const neighbourhood_type & neighbourhood_)
+  {
+    DT_THROW_IF(is_open(), std::logic_error, "Hit table file '" << _filename_ << "' is already open !");
+    DT_THROW_IF(neighbourhood_.offsets.empty(), std::logic_error, "Missing calorimeter neighbourhood !");
+    _buffer_.resize(BUFFER_SIZE);
+    _file_.rdbuf()->pubsetbuf(_buffer_.data(), _buffer_.size());
+    _file_.open(filename_.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    DT_THROW_IF(! _file_, std::runtime_error, "Cannot create hit table file '" << filename_ << "' !");
+    _filename_ = filename_;
+    _writing_ = true;
+    _neighbourhood_ = neighbourhood_;
+    _number_of_events_ = 0;
+
+    const uint32_t nchannels = _neighbourhood_.offsets.size() - 1;
+    const uint32_t nneighbours = _neighbourhood_.neighbours.size();
+    _file_.write(MAGIC, sizeof(MAGIC));
+    write_value(_file_, VERSION);
+    write_value(_file_, BYTE_ORDER_MARK);
+    write_value(_file_, nchannels);
+    write_value(_file_, nneighbours);
+    write_column(_file_, _neighbourhood_.offsets);
+    write_column(_file_, _neighbourhood_.neighbours);
+    DT_THROW_IF(! _file_, std::runtime_error, "Cannot write hit table file '" << filename_ << "' !");
+    return;
+  }
+
+  void hit_table::open(const std::string & filename_)
+  {
+    DT_THROW_IF(is_open(), std::logic_error, "Hit table file '" << _filename_ << "' is already open !");
+    _buffer_.resize(BUFFER_SIZE);
+    _file_.rdbuf()->pubsetbuf(_buffer_.data(), _buffer_.size());
+    _file_.open(filename_.c_str(), std::ios::in | std::ios::binary);
+    DT_THROW_IF(! _file_, std::runtime_error, "Cannot open hit table file '" << filename_ << "' !");
+    _filename_ = filename_;
+    _writing_ = false;
+    _number_of_events_ = 0;
+
+    char a_magic[sizeof(MAGIC)];
+    _file_.read(a_magic, sizeof(a_magic));
+    DT_THROW_IF(! _file_ || std::memcmp(a_magic, MAGIC, sizeof(MAGIC)) != 0, std::runtime_error,
+                "File '" << filename_ << "' is not a hit table file !");
+    uint32_t a_version = 0;
+    uint32_t a_byte_order_mark = 0;
+    uint32_t nchannels = 0;
+    uint32_t nneighbours = 0;
+    read_value(_file_, a_version);
+    read_value(_file_, a_byte_order_mark);
+    read_value(_file_, nchannels);
+    read_value(_file_, nneighbours);
+    DT_THROW_IF(! _file_ || a_version != VERSION, std::runtime_error,
+                "Hit table file '" << filename_ << "' has unsupported version " << a_version << " !");
+    DT_THROW_IF(a_byte_order_mark != BYTE_ORDER_MARK, std::runtime_error,
+                "Hit table file '" << filename_ << "' has been written with another byte order !");
+    read_column(_file_, _neighbourhood_.offsets, nchannels + 1);
+    read_column(_file_, _neighbourhood_.neighbours, nneighbours);
+    DT_THROW_IF(! _file_, std::runtime_error, "Truncated hit table file '" << filename_ << "' !");
+
+    // Events are clustered with this neighbourhood
+    DT_THROW_IF(nchannels >= INVALID_CHANNEL, std::runtime_error,
+                "Hit table file '" << filename_ << "' has too many channels (" << nchannels << ") !");
+    DT_THROW_IF(_neighbourhood_.offsets.front() != 0 || _neighbourhood_.offsets.back() != nneighbours,
+                std::runtime_error, "Hit table file '" << filename_ << "' has an invalid neighbourhood !");
+    for (uint32_t ichannel = 0; ichannel < nchannels; ichannel++) {
+      DT_THROW_IF(_neighbourhood_.offsets[ichannel] > _neighbourhood_.offsets[ichannel + 1],
+                  std::runtime_error, "Hit table file '" << filename_ << "' has an invalid neighbourhood !");
+    }
+    for (const auto & ineighbour : _neighbourhood_.neighbours) {
+      DT_THROW_IF(ineighbour >= nchannels, std::runtime_error,
+                  "Hit table file '" << filename_ << "' has an invalid neighbour channel " << ineighbour << " !");
+    }
+    return;
+  }
+
+  void hit_table::resume(const std::string & filename_, const neighbourhood_type & neighbourhood_,
+                         uint64_t number_of_events_, uint64_t size_)
+  {
+    // Check the events written up to the checkpoint
+    open(filename_);
+    DT_THROW_IF(_neighbourhood_.offsets != neighbourhood_.offsets || _neighbourhood_.neighbours != neighbourhood_.neighbours,
+                std::logic_error, "Hit table file '" << filename_ << "' has another calorimeter neighbourhood !");
+    event_type an_event;
+    for (uint64_t ievent = 0; ievent < number_of_events_; ievent++) {
+      DT_THROW_IF(! read(an_event), std::runtime_error,
+                  "Hit table file '" << filename_ << "' has " << ievent << " events, "
+                  << number_of_events_ << " were written at the checkpoint !");
+    }
+    DT_THROW_IF(static_cast<uint64_t>(_file_.tellg()) != size_, std::runtime_error,
+                "Hit table file '" << filename_ << "' events do not end where they did at the checkpoint !");
+    _file_.close();
+
+    // Events written after the checkpoint are dropped, they are processed again
+    DT_THROW_IF(::truncate(filename_.c_str(), size_) != 0, std::runtime_error,
+                "Cannot truncate hit table file '" << filename_ << "' !");
+    _file_.open(filename_.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    DT_THROW_IF(! _file_, std::runtime_error, "Cannot open hit table file '" << filename_ << "' !");
+    _file_.seekp(0, std::ios::end);
+    _writing_ = true;
+    _number_of_events_ = number_of_events_;
+    return;
+  }
+
+  const hit_table::neighbourhood_type & hit_table::get_neighbourhood() const
+  {
+    return _neighbourhood_;
+  }
+
+  uint64_t hit_table::get_number_of_events() const
+  {
+    return _number_of_events_;
+  }
+
+  void hit_table::write(const event_type & event_)
+  {
+    DT_THROW_IF(! is_open() || ! _writing_, std::logic_error, "Hit table file is not open for writing !");
+    const uint32_t ngammas = event_.gamma_track_ids.size();
+    const uint32_t nrows = event_.size();
+    std::lock_guard<std::mutex> lock(_mutex_);
+    write_value(_file_, event_.run_number);
+    write_value(_file_, event_.event_number);
+    write_value(_file_, event_.flags);
+    write_value(_file_, event_.number_of_primary_gammas);
+    write_value(_file_, event_.number_of_calibrated_hits);
+    write_value(_file_, event_.number_of_step_hits);
+    write_value(_file_, ngammas);
+    write_value(_file_, event_.number_of_gamma_hits);
+    write_value(_file_, nrows);
+    write_column(_file_, event_.gamma_track_ids);
+    write_column(_file_, event_.channels);
+    write_column(_file_, event_.hit_gammas);
+    write_column(_file_, event_.truth_track_ids);
+    write_column(_file_, event_.times);
+    write_column(_file_, event_.energies);
+    DT_THROW_IF(! _file_, std::runtime_error, "Cannot write hit table file '" << _filename_ << "' !");
+    _number_of_events_++;
+    return;
+  }
+
+  bool hit_table::read(event_type & event_)
+  {
+    DT_THROW_IF(! is_open() || _writing_, std::logic_error, "Hit table file is not open for reading !");
+    read_value(_file_, event_.run_number);
+    if (_file_.eof()) return false;
+    uint32_t ngammas = 0;
+    uint32_t nrows = 0;
+    read_value(_file_, event_.event_number);
+    read_value(_file_, event_.flags);
+    read_value(_file_, event_.number_of_primary_gammas);
+    read_value(_file_, event_.number_of_calibrated_hits);
+    read_value(_file_, event_.number_of_step_hits);
+    read_value(_file_, ngammas);
+    read_value(_file_, event_.number_of_gamma_hits);
+    read_value(_file_, nrows);
+    read_column(_file_, event_.gamma_track_ids, ngammas);
+    read_column(_file_, event_.channels, nrows);
+    read_column(_file_, event_.hit_gammas, nrows);
+    read_column(_file_, event_.truth_track_ids, nrows);
+    read_column(_file_, event_.times, nrows);
+    read_column(_file_, event_.energies, nrows);
+    DT_THROW_IF(! _file_, std::runtime_error, "Truncated hit table file '" << _filename_ << "' !");
+
+    // Rows are used to index the neighbourhood and the gammas when sequences are built
+    const size_t nchannels = _neighbourhood_.offsets.size() - 1;
+    DT_THROW_IF(event_.number_of_gamma_hits > nrows, std::runtime_error,
+                "Hit table file '" << _filename_ << "' event " << _number_of_events_ << " has "
+                << event_.number_of_gamma_hits << " gamma hits out of " << nrows << " rows !");
+    for (uint32_t irow = 0; irow < nrows; irow++) {
+      const channel_type a_channel = event_.channels[irow];
+      DT_THROW_IF(a_channel >= nchannels && a_channel != INVALID_CHANNEL, std::runtime_error,
+                  "Hit table file '" << _filename_ << "' event " << _number_of_events_ << " has channel "
+                  << a_channel << " out of the " << nchannels << " channels of its neighbourhood !");
+      const uint32_t a_gamma = event_.hit_gammas[irow];
+      DT_THROW_IF(a_gamma >= ngammas && (irow < event_.number_of_gamma_hits || a_gamma != NO_GAMMA),
+                  std::runtime_error,
+                  "Hit table file '" << _filename_ << "' event " << _number_of_events_ << " has gamma index "
+                  << a_gamma << " out of its " << ngammas << " gammas !");
+    }
+    _number_of_events_++;
+    return true;
+  }
+
+  uint64_t hit_table::flush()
+  {
+    DT_THROW_IF(! is_open() || ! _writing_, std::logic_error, "Hit table file is not open for writing !");
+    std::lock_guard<std::mutex> lock(_mutex_);
+    _file_.flush();
+    DT_THROW_IF(! _file_, std::runtime_error, "Cannot write hit table file '" << _filename_ << "' !");
+    return _file_.tellp();
+  }
+
+  void hit_table::close()
+  {
+    DT_THROW_IF(! is_open(), std::logic_error, "No hit table file is open !");
+    _file_.close();
+    return;
+  }
+
+} // namespace analysis
+
+// end of hit_table.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,186 @@
+/* hit_table.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Minimal per event calorimeter hit tables, enough to build again the
+ * simulated, reconstructed and clustered gamma sequences without the
+ * data processing pipeline. Each row holds a calorimeter channel, hit
+ * time and energy, the index of the reconstructed gamma it is associated
+ * to and the primary track id of the first simulated hit in the channel.
+ * Hits associated to reconstructed gammas come first, in gamma order,
+ * followed by the other calibrated hits. Gamma hits of calorimeters with
+ * unknown channel are stored with the invalid channel 0xFFFF, as they make
+ * isolated clusters; the other ones are not stored.
+ *
+ * The file starts with the calorimeter neighbourhood, then events follow
+ * one after the other, their columns being stored contiguously:
+ *
+ *   header : magic "SNGTHITS", uint32 version, uint32 byte order mark
+ *            (0x01020304 in host order), uint32 number of channels,
+ *            uint32 number of neighbours, uint32 offsets[channels + 1],
+ *            uint16 neighbours[neighbours]
+ *   event  : int32 run number, int32 event number, uint32 flags,
+ *            uint32 primary gammas, uint32 calibrated hits, uint32 step
+ *            hits, uint32 gammas, uint32 gamma hits, uint32 rows, then
+ *            int32 gamma_track_ids[gammas], uint16 channels[rows],
+ *            uint32 hit_gammas[rows], int32 truth_track_ids[rows],
+ *            double times[rows], double energies[rows]
+ *
+ * Values are stored in host byte order. Channels are checked against the
+ * neighbourhood when the file is read.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_HIT_TABLE_H_
+#define ANALYSIS_HIT_TABLE_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <vector>
+#include <fstream>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+namespace analysis {
+
+  class hit_table
+  {
+  public:
+
+    /// Typedef for dense channel number
+    typedef uint16_t channel_type;
+
+    /// Current format version
+    static const uint32_t VERSION = 1;
+
+    /// Gamma index of hits not associated to a reconstructed gamma
+    static const uint32_t NO_GAMMA = 0xFFFFFFFF;
+
+    /// Channel of hits of calorimeters with unknown channel
+    static const channel_type INVALID_CHANNEL = 0xFFFF;
+
+    /// Banks found in the event record
+    enum flag_type {
+      HAS_SIMULATED_DATA      = 0x1, //!< Simulated data
+      HAS_CALIBRATED_DATA     = 0x2, //!< Calibrated data
+      HAS_PARTICLE_TRACK_DATA = 0x4, //!< Particle track data
+      HAS_STEP_HITS           = 0x8  //!< Simulated calorimeter step hits
+    };
+
+    /// Hit table of an event
+    struct event_type {
+      int32_t  run_number;   //!< Run number (-1 if unknown)
+      int32_t  event_number; //!< Event number (-1 if unknown)
+      uint32_t flags;        //!< Banks found
+      uint32_t number_of_primary_gammas;  //!< Simulated primary gammas
+      uint32_t number_of_calibrated_hits; //!< Calibrated hits, with unknown channel or not
+      uint32_t number_of_step_hits;       //!< Simulated calorimeter step hits, with unknown channel or not
+      uint32_t number_of_gamma_hits;      //!< Leading rows associated to reconstructed gammas
+
+      std::vector<int>          gamma_track_ids; //!< Track id of each reconstructed gamma
+      std::vector<channel_type> channels;        //!< Channels
+      std::vector<uint32_t>     hit_gammas;      //!< Reconstructed gamma index (NO_GAMMA if none)
+      std::vector<int>          truth_track_ids; //!< Primary track id of the first simulated hit (0 if none)
+      std::vector<double>       times;           //!< Times
+      std::vector<double>       energies;        //!< Energies
+
+      /// Clear the event
+      void clear();
+
+      /// Return the number of rows
+      size_t size() const;
+
+      /// Add a row
+      void push_back(channel_type channel_, uint32_t gamma_, int truth_track_id_, double time_, double energy_);
+    };
+
+    /// Neighbourhood of the calorimeter channels
+    struct neighbourhood_type {
+      std::vector<uint32_t>     offsets;    //!< CSR row offsets
+      std::vector<channel_type> neighbours; //!< CSR neighbour channels
+    };
+
+    /// Constructor
+    hit_table();
+
+    /// Destructor
+    ~hit_table();
+
+    /// Check if a file is open
+    bool is_open() const;
+
+    /// Create a file holding a calorimeter neighbourhood
+    void create(const std::string & filename_, const neighbourhood_type & neighbourhood_);
+
+    /// Open a file for reading
+    void open(const std::string & filename_);
+
+    /// Open an existing file to append events, keeping only its first events up to a
+    /// checkpoint, given by their number and the file size they end at
+    void resume(const std::string & filename_, const neighbourhood_type & neighbourhood_,
+                uint64_t number_of_events_, uint64_t size_);
+
+    /// Return the calorimeter neighbourhood
+    const neighbourhood_type & get_neighbourhood() const;
+
+    /// Return the number of events written or read
+    uint64_t get_number_of_events() const;
+
+    /// Write an event, may be called concurrently
+    void write(const event_type & event_);
+
+    /// Read the next event, return false at the end of the file. Events with
+    /// channels out of the neighbourhood (other than INVALID_CHANNEL) or gamma
+    /// indexes out of range are rejected
+    bool read(event_type & event_);
+
+    /// Flush the events written and return the file size
+    uint64_t flush();
+
+    /// Close the file
+    void close();
+
+  private:
+
+    std::fstream _file_;     //!< File
+    std::string _filename_;  //!< File name
+    bool _writing_;          //!< Writing mode
+    neighbourhood_type _neighbourhood_; //!< Calorimeter neighbourhood
+    uint64_t _number_of_events_; //!< Number of events written or read
+    std::vector<char> _buffer_;  //!< Stream buffer
+    std::mutex _mutex_;          //!< Serialize writes
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_HIT_TABLE_H_
+
+// end of hit_table.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
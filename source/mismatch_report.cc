@@ -0,0 +1,124 @@
+// mismatch_report.cc
+
+// Ourselves:
+#include <mismatch_report.h>
+
+// This project:
+#include <run_state.h>
+
+namespace analysis {
+
+  const uint64_t mismatch_report::DEFAULT_FIRST;
+  const uint64_t mismatch_report::DEFAULT_EVERY;
+
+  const char * mismatch_report::get_category_name(category_id category_)
+  {
+    switch (category_) {
+    case GT_MISMATCH:              return "gt_mismatch";
+    case GT_NO_SIMULATED_GAMMA:    return "gt_no_simulated_gamma";
+    case NO_GT_MISMATCH:           return "no_gt_mismatch";
+    case NO_GT_NO_SIMULATED_GAMMA: return "no_gt_no_simulated_gamma";
+    case SECONDARY_PARTICLE:       return "secondary_particle";
+    default:                       return "";
+    }
+  }
+
+  mismatch_report::mismatch_report()
+  {
+    _first_ = DEFAULT_FIRST;
+    _every_ = DEFAULT_EVERY;
+    clear();
+    return;
+  }
+
+  void mismatch_report::set_sampling(uint64_t first_, uint64_t every_)
+  {
+    _first_ = first_;
+    _every_ = every_;
+    return;
+  }
+
+  uint64_t mismatch_report::count(category_id category_)
+  {
+    return _counts_[category_].fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  bool mismatch_report::is_sampled(uint64_t rank_) const
+  {
+    if (rank_ <= _first_) return true;
+    return _every_ > 0 && (rank_ - _first_) % _every_ == 0;
+  }
+
+  uint64_t mismatch_report::get_count(category_id category_) const
+  {
+    return _counts_[category_].load(std::memory_order_relaxed);
+  }
+
+  uint64_t mismatch_report::get_number_of_sampled(category_id category_) const
+  {
+    const uint64_t a_count = get_count(category_);
+    if (a_count <= _first_) return a_count;
+    return _first_ + (_every_ > 0 ? (a_count - _first_) / _every_ : 0);
+  }
+
+  void mismatch_report::add_kinds(bool clustered_, const gamma_sequence_matcher::match_type & match_)
+  {
+    for (size_t i = 0; i < gamma_sequence_matcher::NUMBER_OF_MISMATCH_KINDS; i++) {
+      if (match_.kinds[i] > 0) _kinds_[clustered_][i].fetch_add(match_.kinds[i], std::memory_order_relaxed);
+    }
+    return;
+  }
+
+  uint64_t mismatch_report::get_kind_count(bool clustered_, gamma_sequence_matcher::mismatch_kind kind_) const
+  {
+    return _kinds_[clustered_][kind_].load(std::memory_order_relaxed);
+  }
+
+  void mismatch_report::clear()
+  {
+    for (size_t i = 0; i < NUMBER_OF_CATEGORIES; i++) _counts_[i] = 0;
+    for (size_t i = 0; i < gamma_sequence_matcher::NUMBER_OF_MISMATCH_KINDS; i++) {
+      _kinds_[0][i] = 0;
+      _kinds_[1][i] = 0;
+    }
+    return;
+  }
+
+  void mismatch_report::export_counters(run_state & state_, const std::string & prefix_) const
+  {
+    for (size_t i = 0; i < NUMBER_OF_CATEGORIES; i++) {
+      const category_id a_category = static_cast<category_id>(i);
+      state_.set_counter(prefix_ + get_category_name(a_category), get_count(a_category));
+    }
+    for (size_t i = 0; i < gamma_sequence_matcher::NUMBER_OF_MISMATCH_KINDS; i++) {
+      const gamma_sequence_matcher::mismatch_kind a_kind = static_cast<gamma_sequence_matcher::mismatch_kind>(i);
+      state_.set_counter(prefix_ + "gt." + gamma_sequence_matcher::get_mismatch_kind_name(a_kind), get_kind_count(false, a_kind));
+      state_.set_counter(prefix_ + "no_gt." + gamma_sequence_matcher::get_mismatch_kind_name(a_kind), get_kind_count(true, a_kind));
+    }
+    return;
+  }
+
+  void mismatch_report::import_counters(const run_state & state_, const std::string & prefix_)
+  {
+    for (size_t i = 0; i < NUMBER_OF_CATEGORIES; i++) {
+      const std::string a_name = prefix_ + get_category_name(static_cast<category_id>(i));
+      if (state_.has_counter(a_name)) _counts_[i] += state_.get_counter(a_name);
+    }
+    for (size_t i = 0; i < gamma_sequence_matcher::NUMBER_OF_MISMATCH_KINDS; i++) {
+      const std::string a_kind = gamma_sequence_matcher::get_mismatch_kind_name(static_cast<gamma_sequence_matcher::mismatch_kind>(i));
+      if (state_.has_counter(prefix_ + "gt." + a_kind)) _kinds_[0][i] += state_.get_counter(prefix_ + "gt." + a_kind);
+      if (state_.has_counter(prefix_ + "no_gt." + a_kind)) _kinds_[1][i] += state_.get_counter(prefix_ + "no_gt." + a_kind);
+    }
+    return;
+  }
+
+} // namespace analysis
+
+// end of mismatch_report.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,126 @@
+/* mismatch_report.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Counters of the events whose simulated and reconstructed (or clustered)
+ * gamma sequences differ, per category. Only a sample of the occurrences
+ * is meant to be logged: the first ones, then one every given number.
+ * The differences found by the sequence matcher are also tallied per kind
+ * (split, merge, missing or extra calorimeter, unmatched gamma), with and
+ * without gamma tracking. Counting is a relaxed atomic increment so that
+ * the report may be shared by the processing threads.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_MISMATCH_REPORT_H_
+#define ANALYSIS_MISMATCH_REPORT_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// This project:
+#include <gamma_sequence_matcher.h>
+
+namespace analysis {
+
+  class run_state;
+
+  class mismatch_report
+  {
+  public:
+
+    /// Mismatch categories
+    enum category_id {
+      GT_MISMATCH              = 0, //!< Reconstructed sequences differ from simulated ones
+      GT_NO_SIMULATED_GAMMA    = 1, //!< Reconstructed gammas without simulated ones
+      NO_GT_MISMATCH           = 2, //!< Clustered sequences differ from simulated ones
+      NO_GT_NO_SIMULATED_GAMMA = 3, //!< Clusters without simulated gammas
+      SECONDARY_PARTICLE       = 4, //!< Calorimeter first hit by a secondary particle
+      NUMBER_OF_CATEGORIES     = 5
+    };
+
+    /// Default number of first occurrences sampled
+    static const uint64_t DEFAULT_FIRST = 10;
+
+    /// Default sampling period after the first occurrences
+    static const uint64_t DEFAULT_EVERY = 10000;
+
+    /// Return the name of a category
+    static const char * get_category_name(category_id category_);
+
+    /// Constructor
+    mismatch_report();
+
+    /// Set the sampling: the 'first_' occurrences, then one every 'every_' (never if 0)
+    void set_sampling(uint64_t first_, uint64_t every_);
+
+    /// Count an occurrence and return its rank (from 1)
+    uint64_t count(category_id category_);
+
+    /// Check if the occurrence of a given rank is sampled
+    bool is_sampled(uint64_t rank_) const;
+
+    /// Return the number of occurrences of a category
+    uint64_t get_count(category_id category_) const;
+
+    /// Return the number of sampled occurrences of a category
+    uint64_t get_number_of_sampled(category_id category_) const;
+
+    /// Account for the differences of an event, with ('clustered_' unset) or without gamma tracking
+    void add_kinds(bool clustered_, const gamma_sequence_matcher::match_type & match_);
+
+    /// Return the number of differences of a kind
+    uint64_t get_kind_count(bool clustered_, gamma_sequence_matcher::mismatch_kind kind_) const;
+
+    /// Zero the counters
+    void clear();
+
+    /// Store the counters in a run state
+    void export_counters(run_state & state_, const std::string & prefix_) const;
+
+    /// Add the counters found in a run state
+    void import_counters(const run_state & state_, const std::string & prefix_);
+
+  private:
+
+    uint64_t _first_; //!< Number of first occurrences sampled
+    uint64_t _every_; //!< Sampling period after the first occurrences
+    std::atomic<uint64_t> _counts_[NUMBER_OF_CATEGORIES]; //!< Occurrences per category
+    std::atomic<uint64_t> _kinds_[2][gamma_sequence_matcher::NUMBER_OF_MISMATCH_KINDS]; //!< Differences per kind
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_MISMATCH_REPORT_H_
+
+// end of mismatch_report.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
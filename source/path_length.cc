@@ -0,0 +1,80 @@
+// path_length.cc
+
+// Ourselves:
+#include <path_length.h>
+
+// Standard library:
+#include <cmath>
+
+namespace analysis {
+
+  const size_t path_length::NUMBER_OF_LANES;
+
+  double path_length::sum(const double * x0_, const double * y0_, const double * z0_,
+                          const double * x1_, const double * y1_, const double * z1_,
+                          size_t nsegments_)
+  {
+    // Independent partial sums so that additions need not be reassociated
+    double lanes[NUMBER_OF_LANES] = {0.0, 0.0, 0.0, 0.0};
+    size_t iseg = 0;
+    for (; iseg + NUMBER_OF_LANES <= nsegments_; iseg += NUMBER_OF_LANES) {
+      for (size_t ilane = 0; ilane < NUMBER_OF_LANES; ilane++) {
+        const double dx = x1_[iseg + ilane] - x0_[iseg + ilane];
+        const double dy = y1_[iseg + ilane] - y0_[iseg + ilane];
+        const double dz = z1_[iseg + ilane] - z0_[iseg + ilane];
+        lanes[ilane] += std::sqrt(dx * dx + dy * dy + dz * dz);
+      }
+    }
+    for (size_t ilane = 0; iseg < nsegments_; iseg++, ilane++) {
+      const double dx = x1_[iseg] - x0_[iseg];
+      const double dy = y1_[iseg] - y0_[iseg];
+      const double dz = z1_[iseg] - z0_[iseg];
+      lanes[ilane] += std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  }
+
+  void path_length::clear()
+  {
+    _x0_.clear();
+    _y0_.clear();
+    _z0_.clear();
+    _x1_.clear();
+    _y1_.clear();
+    _z1_.clear();
+    return;
+  }
+
+  void path_length::add(double x0_, double y0_, double z0_,
+                        double x1_, double y1_, double z1_)
+  {
+    _x0_.push_back(x0_);
+    _y0_.push_back(y0_);
+    _z0_.push_back(z0_);
+    _x1_.push_back(x1_);
+    _y1_.push_back(y1_);
+    _z1_.push_back(z1_);
+    return;
+  }
+
+  size_t path_length::size() const
+  {
+    return _x0_.size();
+  }
+
+  double path_length::get_length() const
+  {
+    return sum(_x0_.data(), _y0_.data(), _z0_.data(),
+               _x1_.data(), _y1_.data(), _z1_.data(), _x0_.size());
+  }
+
+} // namespace analysis
+
+// end of path_length.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
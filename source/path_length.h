@@ -0,0 +1,88 @@
+/* path_length.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Total length of a set of segments. Segment ends are stored as
+ * structure-of-arrays coordinates, kept from one event to the other, and
+ * summed by a branch free kernel with a fixed number of partial sums: the
+ * loop can be vectorized and the result does not depend on the vector
+ * width.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_PATH_LENGTH_H_
+#define ANALYSIS_PATH_LENGTH_H_ 1
+
+// Standard libraries:
+#include <vector>
+#include <cstddef>
+
+namespace analysis {
+
+  class path_length
+  {
+  public:
+
+    /// Number of partial sums of the kernel
+    static const size_t NUMBER_OF_LANES = 4;
+
+    /// Sum the lengths of 'nsegments_' segments given by the coordinates of their ends
+    static double sum(const double * x0_, const double * y0_, const double * z0_,
+                      const double * x1_, const double * y1_, const double * z1_,
+                      size_t nsegments_);
+
+    /// Remove the segments
+    void clear();
+
+    /// Add a segment
+    void add(double x0_, double y0_, double z0_,
+             double x1_, double y1_, double z1_);
+
+    /// Return the number of segments
+    size_t size() const;
+
+    /// Return the total length of the segments
+    double get_length() const;
+
+  private:
+
+    std::vector<double> _x0_; //!< Start abscissas
+    std::vector<double> _y0_; //!< Start ordinates
+    std::vector<double> _z0_; //!< Start heights
+    std::vector<double> _x1_; //!< Stop abscissas
+    std::vector<double> _y1_; //!< Stop ordinates
+    std::vector<double> _z1_; //!< Stop heights
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_PATH_LENGTH_H_
+
+// end of path_length.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,317 @@
+// run_state.cc
+
+// Ourselves:
+#include <run_state.h>
+
+// Standard library:
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+// - Bayeux/mygsl
+#include <mygsl/histogram_pool.h>
+
+// This project:
+#include <histogram_registry.h>
+
+namespace analysis {
+
+  namespace {
+
+    /// File header and trailer
+    const char MAGIC[8] = {'S', 'N', 'G', 'T', 'E', 'F', 'F', '\0'};
+    const uint32_t END_MARKER = 0x454e4421;
+
+    void write_u32(std::ostream & out_, uint32_t value_)
+    {
+      char bytes[4];
+      for (size_t i = 0; i < 4; i++) bytes[i] = static_cast<char>((value_ >> (8 * i)) & 0xff);
+      out_.write(bytes, 4);
+    }
+
+    void write_u64(std::ostream & out_, uint64_t value_)
+    {
+      char bytes[8];
+      for (size_t i = 0; i < 8; i++) bytes[i] = static_cast<char>((value_ >> (8 * i)) & 0xff);
+      out_.write(bytes, 8);
+    }
+
+    void write_f64(std::ostream & out_, double value_)
+    {
+      uint64_t bits;
+      std::memcpy(&bits, &value_, sizeof(bits));
+      write_u64(out_, bits);
+    }
+
+    void write_string(std::ostream & out_, const std::string & value_)
+    {
+      write_u32(out_, value_.size());
+      out_.write(value_.data(), value_.size());
+    }
+
+    uint64_t read_bytes(std::istream & in_, size_t nbytes_)
+    {
+      unsigned char bytes[8];
+      in_.read(reinterpret_cast<char *>(bytes), nbytes_);
+      DT_THROW_IF(! in_, std::runtime_error, "Truncated run state file !");
+      uint64_t value = 0;
+      for (size_t i = 0; i < nbytes_; i++) value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+      return value;
+    }
+
+    uint32_t read_u32(std::istream & in_)
+    {
+      return read_bytes(in_, 4);
+    }
+
+    uint64_t read_u64(std::istream & in_)
+    {
+      return read_bytes(in_, 8);
+    }
+
+    double read_f64(std::istream & in_)
+    {
+      const uint64_t bits = read_u64(in_);
+      double value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+
+    std::string read_string(std::istream & in_)
+    {
+      std::string value(read_u32(in_), '\0');
+      in_.read(&value[0], value.size());
+      DT_THROW_IF(! in_, std::runtime_error, "Truncated run state file !");
+      return value;
+    }
+
+  }
+
+  const uint32_t run_state::VERSION;
+
+  run_state::run_state()
+  {
+    clear();
+    return;
+  }
+
+  void run_state::clear()
+  {
+    _number_of_processed_events_ = 0;
+    _counters_.clear();
+    _histograms_.clear();
+    return;
+  }
+
+  uint64_t run_state::get_number_of_processed_events() const
+  {
+    return _number_of_processed_events_;
+  }
+
+  void run_state::set_number_of_processed_events(uint64_t number_)
+  {
+    _number_of_processed_events_ = number_;
+    return;
+  }
+
+  bool run_state::has_counter(const std::string & name_) const
+  {
+    return _counters_.count(name_) != 0;
+  }
+
+  uint64_t run_state::get_counter(const std::string & name_) const
+  {
+    counter_dict_type::const_iterator found = _counters_.find(name_);
+    DT_THROW_IF(found == _counters_.end(), std::logic_error, "No counter named '" << name_ << "' !");
+    return found->second;
+  }
+
+  void run_state::set_counter(const std::string & name_, uint64_t value_)
+  {
+    _counters_[name_] = value_;
+    return;
+  }
+
+  const run_state::counter_dict_type & run_state::get_counters() const
+  {
+    return _counters_;
+  }
+
+  const std::vector<run_state::histogram_type> & run_state::get_histograms() const
+  {
+    return _histograms_;
+  }
+
+  void run_state::add_histograms(const mygsl::histogram_pool & pool_)
+  {
+    std::vector<std::string> the_names;
+    pool_.names(the_names);
+    for (const auto & iname : the_names) {
+      if (histogram_registry::is_template(iname) || ! pool_.has_1d(iname)) continue;
+      const mygsl::histogram_1d & a_histo = pool_.get_1d(iname);
+      histogram_type an_entry;
+      an_entry.name = iname;
+      an_entry.group = pool_.get_group(iname);
+      an_entry.title = pool_.get_title(iname);
+      an_entry.min = a_histo.min();
+      an_entry.max = a_histo.max();
+      an_entry.underflow = a_histo.underflow();
+      an_entry.overflow = a_histo.overflow();
+      an_entry.contents.resize(a_histo.bins());
+      for (size_t ibin = 0; ibin < a_histo.bins(); ibin++) {
+        an_entry.contents[ibin] = a_histo.get(ibin);
+      }
+      _histograms_.push_back(an_entry);
+    }
+    return;
+  }
+
+  void run_state::fill_histograms(mygsl::histogram_pool & pool_) const
+  {
+    for (const auto & ientry : _histograms_) {
+      if (! pool_.has(ientry.name))
+        {
+          mygsl::histogram_1d & h = pool_.add_1d(ientry.name, ientry.title, ientry.group);
+          h.initialize(ientry.contents.size(), ientry.min, ientry.max);
+        }
+      mygsl::histogram_1d & a_histo = pool_.grab_1d(ientry.name);
+      DT_THROW_IF(a_histo.bins() != ientry.contents.size() ||
+                  a_histo.min() != ientry.min || a_histo.max() != ientry.max,
+                  std::logic_error,
+                  "Histogram '" << ientry.name << "' binning differs from the stored one !");
+
+      // Contents are added back bin per bin, each as a single weighted entry
+      for (size_t ibin = 0; ibin < ientry.contents.size(); ibin++) {
+        if (ientry.contents[ibin] == 0) continue;
+        const std::pair<double, double> a_range = a_histo.get_range(ibin);
+        a_histo.fill(0.5 * (a_range.first + a_range.second), ientry.contents[ibin]);
+      }
+      if (ientry.underflow != 0) a_histo.fill(std::nextafter(ientry.min, -HUGE_VAL), ientry.underflow);
+      if (ientry.overflow != 0) a_histo.fill(ientry.max, ientry.overflow);
+    }
+    return;
+  }
+
+  void run_state::merge(const run_state & other_)
+  {
+    _number_of_processed_events_ += other_._number_of_processed_events_;
+    for (const auto & icounter : other_._counters_) {
+      _counters_[icounter.first] += icounter.second;
+    }
+
+    std::map<std::string, size_t> the_indexes;
+    for (size_t i = 0; i < _histograms_.size(); i++) the_indexes[_histograms_[i].name] = i;
+    for (const auto & ientry : other_._histograms_) {
+      std::map<std::string, size_t>::const_iterator found = the_indexes.find(ientry.name);
+      if (found == the_indexes.end())
+        {
+          _histograms_.push_back(ientry);
+          continue;
+        }
+      histogram_type & an_entry = _histograms_[found->second];
+      DT_THROW_IF(an_entry.contents.size() != ientry.contents.size() ||
+                  an_entry.min != ientry.min || an_entry.max != ientry.max,
+                  std::logic_error,
+                  "Histogram '" << ientry.name << "' binnings differ !");
+      for (size_t ibin = 0; ibin < ientry.contents.size(); ibin++) {
+        an_entry.contents[ibin] += ientry.contents[ibin];
+      }
+      an_entry.underflow += ientry.underflow;
+      an_entry.overflow += ientry.overflow;
+    }
+    return;
+  }
+
+  void run_state::store(const std::string & filename_) const
+  {
+    const std::string a_tmp_filename = filename_ + ".tmp";
+    {
+      std::ofstream out(a_tmp_filename.c_str(), std::ios::binary | std::ios::trunc);
+      DT_THROW_IF(! out, std::runtime_error, "Cannot open run state file '" << a_tmp_filename << "' !");
+      out.write(MAGIC, sizeof(MAGIC));
+      write_u32(out, VERSION);
+      write_u64(out, _number_of_processed_events_);
+
+      write_u32(out, _counters_.size());
+      for (const auto & icounter : _counters_) {
+        write_string(out, icounter.first);
+        write_u64(out, icounter.second);
+      }
+
+      write_u32(out, _histograms_.size());
+      for (const auto & ientry : _histograms_) {
+        write_string(out, ientry.name);
+        write_string(out, ientry.group);
+        write_string(out, ientry.title);
+        write_f64(out, ientry.min);
+        write_f64(out, ientry.max);
+        write_f64(out, ientry.underflow);
+        write_f64(out, ientry.overflow);
+        write_u32(out, ientry.contents.size());
+        for (const auto icontent : ientry.contents) write_f64(out, icontent);
+      }
+
+      write_u32(out, END_MARKER);
+      out.flush();
+      DT_THROW_IF(! out, std::runtime_error, "Cannot write run state file '" << a_tmp_filename << "' !");
+    }
+    DT_THROW_IF(std::rename(a_tmp_filename.c_str(), filename_.c_str()) != 0, std::runtime_error,
+                "Cannot rename run state file '" << a_tmp_filename << "' to '" << filename_ << "' !");
+    return;
+  }
+
+  void run_state::load(const std::string & filename_)
+  {
+    clear();
+    std::ifstream in(filename_.c_str(), std::ios::binary);
+    DT_THROW_IF(! in, std::runtime_error, "Cannot open run state file '" << filename_ << "' !");
+
+    char a_magic[sizeof(MAGIC)];
+    in.read(a_magic, sizeof(a_magic));
+    DT_THROW_IF(! in || std::memcmp(a_magic, MAGIC, sizeof(MAGIC)) != 0, std::runtime_error,
+                "File '" << filename_ << "' is not a run state file !");
+    const uint32_t a_version = read_u32(in);
+    DT_THROW_IF(a_version != VERSION, std::runtime_error,
+                "Run state file '" << filename_ << "' has unsupported version " << a_version << " !");
+    _number_of_processed_events_ = read_u64(in);
+
+    const uint32_t ncounters = read_u32(in);
+    for (uint32_t i = 0; i < ncounters; i++) {
+      const std::string a_name = read_string(in);
+      _counters_[a_name] = read_u64(in);
+    }
+
+    const uint32_t nhistograms = read_u32(in);
+    _histograms_.resize(nhistograms);
+    for (auto & ientry : _histograms_) {
+      ientry.name = read_string(in);
+      ientry.group = read_string(in);
+      ientry.title = read_string(in);
+      ientry.min = read_f64(in);
+      ientry.max = read_f64(in);
+      ientry.underflow = read_f64(in);
+      ientry.overflow = read_f64(in);
+      ientry.contents.resize(read_u32(in));
+      for (auto & icontent : ientry.contents) icontent = read_f64(in);
+    }
+
+    DT_THROW_IF(read_u32(in) != END_MARKER, std::runtime_error,
+                "Run state file '" << filename_ << "' is corrupted !");
+    return;
+  }
+
+} // namespace analysis
+
+// end of run_state.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,135 @@
+/* run_state.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Snapshot of the gamma tracking efficiency module results: the number
+ * of processed event records, raw named counters and the contents of the
+ * histograms (templates excepted). It is stored in a compact binary file
+ * (little endian, fixed width integers and IEEE doubles) headed by a
+ * magic word and a format version. Files are written aside and renamed so
+ * that an interrupted job never leaves a truncated snapshot.
+ *
+ * Histograms are restored with linear binning, as given by the templates.
+ * States of jobs run on parts of a sample are merged by adding counters and
+ * histograms contents by name.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_RUN_STATE_H_
+#define ANALYSIS_RUN_STATE_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+namespace mygsl {
+  class histogram_pool;
+}
+
+namespace analysis {
+
+  class run_state
+  {
+  public:
+
+    /// Current format version
+    static const uint32_t VERSION = 1;
+
+    /// Histogram contents
+    struct histogram_type {
+      std::string name;  //!< Histogram name
+      std::string group; //!< Histogram group
+      std::string title; //!< Histogram title
+      double min;        //!< Lower edge
+      double max;        //!< Upper edge
+      double underflow;  //!< Underflow content
+      double overflow;   //!< Overflow content
+      std::vector<double> contents; //!< Bin contents
+    };
+
+    /// Typedef for named counters (ordered by name)
+    typedef std::map<std::string, uint64_t> counter_dict_type;
+
+    /// Constructor
+    run_state();
+
+    /// Clear the state
+    void clear();
+
+    /// Return the number of processed event records
+    uint64_t get_number_of_processed_events() const;
+
+    /// Set the number of processed event records
+    void set_number_of_processed_events(uint64_t number_);
+
+    /// Check if a counter exists
+    bool has_counter(const std::string & name_) const;
+
+    /// Return a counter value
+    uint64_t get_counter(const std::string & name_) const;
+
+    /// Set a counter value
+    void set_counter(const std::string & name_, uint64_t value_);
+
+    /// Return the counters
+    const counter_dict_type & get_counters() const;
+
+    /// Return the histograms
+    const std::vector<histogram_type> & get_histograms() const;
+
+    /// Copy the 1D histograms of a pool (templates excepted)
+    void add_histograms(const mygsl::histogram_pool & pool_);
+
+    /// Add the histograms contents to a pool, missing histograms are created
+    void fill_histograms(mygsl::histogram_pool & pool_) const;
+
+    /// Add the counters and histograms of another state
+    void merge(const run_state & other_);
+
+    /// Store in a file
+    void store(const std::string & filename_) const;
+
+    /// Load from a file
+    void load(const std::string & filename_);
+
+  private:
+
+    uint64_t _number_of_processed_events_;  //!< Number of processed event records
+    counter_dict_type _counters_;           //!< Raw counters
+    std::vector<histogram_type> _histograms_; //!< Histograms contents
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_RUN_STATE_H_
+
+// end of run_state.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,333 @@
+// snemo_gamma_tracking_efficiency_bench.cc
+//
+// Micro-benchmark of the gamma tracking efficiency kernels: calorimeter
+// clustering (legacy recursive exploration and clustering engine), sequence
+// matching and histogram filling. Events are synthetic and the calorimeter
+// neighbourhood is a mocked grid so that no geometry service is needed.
+//
+// Usage: snemo_gamma_tracking_efficiency_bench [--events N] [--hits N] [--gammas N] [--seed N]
+//
+// Without '--hits', a range of calorimeter multiplicities is scanned to
+// show how each kernel scales.
+
+// Standard library:
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/properties.h>
+// - Bayeux/mygsl
+#include <mygsl/histogram_pool.h>
+
+// This project:
+#include <calorimeter_clustering.h>
+#include <gamma_sequence_matcher.h>
+#include <histogram_registry.h>
+#include <event_arena.h>
+
+namespace {
+
+  typedef analysis::calorimeter_clustering::channel_type channel_type;
+  typedef analysis::gamma_sequence_matcher::gamma_dict_type gamma_dict_type;
+
+  /// Mocked neighbour provider: calorimeter walls as grids of blocks, the
+  /// first neighbours of a block being the blocks sharing one of its sides
+  struct mock_neighbourhood
+  {
+    mock_neighbourhood(size_t nwalls_, size_t ncolumns_, size_t nrows_)
+    {
+      offsets.push_back(0);
+      for (size_t iwall = 0; iwall < nwalls_; iwall++) {
+        for (size_t icolumn = 0; icolumn < ncolumns_; icolumn++) {
+          for (size_t irow = 0; irow < nrows_; irow++) {
+            const size_t a_first = iwall * ncolumns_ * nrows_;
+            if (icolumn > 0)             neighbours.push_back(a_first + (icolumn - 1) * nrows_ + irow);
+            if (icolumn + 1 < ncolumns_) neighbours.push_back(a_first + (icolumn + 1) * nrows_ + irow);
+            if (irow > 0)                neighbours.push_back(a_first + icolumn * nrows_ + irow - 1);
+            if (irow + 1 < nrows_)       neighbours.push_back(a_first + icolumn * nrows_ + irow + 1);
+            offsets.push_back(neighbours.size());
+          }
+        }
+      }
+      return;
+    }
+
+    size_t size() const
+    {
+      return offsets.size() - 1;
+    }
+
+    std::vector<uint32_t> offsets;         //!< CSR row offsets
+    std::vector<channel_type> neighbours;  //!< CSR neighbour channels
+  };
+
+  /// Synthetic event: calorimeter hits grouped by gamma
+  struct synthetic_event
+  {
+    std::vector<channel_type> channels; //!< Hit channels
+    std::vector<double> times;          //!< Hit times
+    std::vector<double> energies;       //!< Hit energies
+    std::vector<int> gammas;            //!< Owning gamma track id
+  };
+
+  /// Generate an event: each gamma deposits energy in a contiguous set of
+  /// blocks grown from a random seed block; hits are never shared
+  void generate_event(std::mt19937 & random_,
+                      const mock_neighbourhood & grid_,
+                      size_t nhits_,
+                      size_t ngammas_,
+                      synthetic_event & event_)
+  {
+    event_.channels.clear();
+    event_.times.clear();
+    event_.energies.clear();
+    event_.gammas.clear();
+    std::vector<bool> used(grid_.size(), false);
+    std::uniform_real_distribution<double> a_flat(0., 1.);
+    nhits_ = std::min(nhits_, grid_.size());
+    for (size_t ihit = 0; ihit < nhits_; ihit++) {
+      const int a_gamma = 1 + ihit % ngammas_;
+      channel_type a_channel = random_() % grid_.size();
+      // Grow from the last block of the same gamma when possible
+      for (size_t jhit = ihit; jhit-- > 0;) {
+        if (event_.gammas[jhit] != a_gamma) continue;
+        const channel_type a_last = event_.channels[jhit];
+        const uint32_t nneighbours = grid_.offsets[a_last + 1] - grid_.offsets[a_last];
+        a_channel = grid_.neighbours[grid_.offsets[a_last] + random_() % nneighbours];
+        break;
+      }
+      while (used[a_channel]) a_channel = (a_channel + 1) % grid_.size();
+      used[a_channel] = true;
+      event_.channels.push_back(a_channel);
+      event_.times.push_back(10. * a_gamma + a_flat(random_));
+      event_.energies.push_back(a_flat(random_));
+      event_.gammas.push_back(a_gamma);
+    }
+    return;
+  }
+
+  /// Mirror of the legacy recursive exploration of the module
+  /// ('get_new_neighbours'), working on channels instead of geometry ids
+  void legacy_explore(channel_type channel_,
+                      const mock_neighbourhood & grid_,
+                      const std::vector<channel_type> & hits_,
+                      std::vector<channel_type> & ccl_,
+                      std::vector<channel_type> & cluster_)
+  {
+    if (std::find(ccl_.begin(), ccl_.end(), channel_) == ccl_.end())
+      ccl_.push_back(channel_);
+    else
+      return;
+
+    std::vector<channel_type> the_calib_neighbours;
+    for (uint32_t i = grid_.offsets[channel_]; i < grid_.offsets[channel_ + 1]; i++) {
+      const channel_type a_neighbour = grid_.neighbours[i];
+      if (std::find(hits_.begin(), hits_.end(), a_neighbour) != hits_.end())
+        if (std::find(ccl_.begin(), ccl_.end(), a_neighbour) == ccl_.end()) {
+          the_calib_neighbours.push_back(a_neighbour);
+          ccl_.push_back(a_neighbour);
+          cluster_.push_back(a_neighbour);
+        }
+    }
+    for (auto ineighbour : the_calib_neighbours)
+      legacy_explore(ineighbour, grid_, hits_, ccl_, cluster_);
+    return;
+  }
+
+  /// Result of a kernel timing
+  struct timing_type
+  {
+    std::string name;  //!< Kernel name
+    double seconds;    //!< Elapsed time
+    size_t checksum;   //!< Value computed by the kernel, keeps it from being optimized out
+  };
+
+  typedef std::chrono::steady_clock clock_type;
+
+  double elapsed(const clock_type::time_point & start_)
+  {
+    return std::chrono::duration<double>(clock_type::now() - start_).count();
+  }
+
+  /// Print a timing, 'nhits_' being the number of hits of all the events
+  void print_timing(const timing_type & timing_, size_t nevents_, size_t nhits_)
+  {
+    std::cout << std::setw(6) << nhits_ / nevents_ << "  "
+              << std::left << std::setw(12) << timing_.name << std::right
+              << std::setw(14) << std::fixed << std::setprecision(0) << nevents_ / timing_.seconds
+              << std::setw(12) << std::setprecision(1) << timing_.seconds * 1e9 / nhits_
+              << std::setw(12) << timing_.checksum << std::endl;
+    return;
+  }
+
+  /// Histogram pool holding the templates used by the module
+  void build_histogram_pool(mygsl::histogram_pool & pool_)
+  {
+    pool_.initialize(datatools::properties());
+    pool_.add_1d("number_of_calos_template", "", "__template").initialize(100, 0., 100.);
+    pool_.add_1d("energy_template", "", "__template").initialize(100, 0., 10.);
+    return;
+  }
+
+  void run(const mock_neighbourhood & grid_,
+           size_t nevents_,
+           size_t nhits_,
+           size_t ngammas_,
+           unsigned int seed_)
+  {
+    std::mt19937 a_random(seed_);
+    std::vector<synthetic_event> the_events(nevents_);
+    size_t ntotal_hits = 0;
+    for (auto & ievent : the_events) {
+      generate_event(a_random, grid_, nhits_, ngammas_, ievent);
+      ntotal_hits += ievent.channels.size();
+    }
+
+    // Legacy recursive exploration
+    timing_type a_legacy = {"legacy", 0., 0};
+    {
+      const clock_type::time_point a_start = clock_type::now();
+      for (const auto & ievent : the_events) {
+        std::vector<channel_type> ccl;
+        for (auto ichannel : ievent.channels) {
+          if (std::find(ccl.begin(), ccl.end(), ichannel) != ccl.end()) continue;
+          std::vector<channel_type> a_cluster(1, ichannel);
+          legacy_explore(ichannel, grid_, ievent.channels, ccl, a_cluster);
+          a_legacy.checksum++;
+        }
+      }
+      a_legacy.seconds = elapsed(a_start);
+    }
+
+    // Clustering engine
+    timing_type a_clustering = {"clustering", 0., 0};
+    analysis::calorimeter_clustering an_engine;
+    an_engine.set_neighbourhood(grid_.size(), grid_.offsets.data(), grid_.neighbours.data());
+    {
+      const clock_type::time_point a_start = clock_type::now();
+      for (const auto & ievent : the_events) {
+        an_engine.process(ievent.channels.data(), ievent.channels.size());
+        a_clustering.checksum += an_engine.get_number_of_clusters();
+      }
+      a_clustering.seconds = elapsed(a_start);
+    }
+
+    // Sequence matching, reconstructed gammas are the clusters. Sequences
+    // are built beforehand so that only the comparison is timed
+    timing_type a_matching = {"matching", 0., 0};
+    analysis::gamma_sequence_matcher a_matcher;
+    analysis::event_arena an_arena;
+    {
+      analysis::event_arena::scope a_scope(an_arena);
+      std::vector<gamma_dict_type> the_simulated_gammas(nevents_);
+      std::vector<gamma_dict_type> the_reconstructed_gammas(nevents_);
+      for (size_t ievent = 0; ievent < nevents_; ievent++) {
+        const synthetic_event & an_event = the_events[ievent];
+        for (size_t ihit = 0; ihit < an_event.channels.size(); ihit++) {
+          the_simulated_gammas[ievent][an_event.gammas[ihit]].insert(an_event.channels[ihit]);
+        }
+        an_engine.process(an_event.channels.data(), an_event.channels.size());
+        for (size_t icluster = 0; icluster < an_engine.get_number_of_clusters(); icluster++) {
+          for (const auto * ihit = an_engine.cluster_begin(icluster); ihit != an_engine.cluster_end(icluster); ihit++) {
+            the_reconstructed_gammas[ievent][icluster + 1].insert(an_event.channels[*ihit]);
+          }
+        }
+      }
+      const clock_type::time_point a_start = clock_type::now();
+      for (size_t ievent = 0; ievent < nevents_; ievent++) {
+        a_matching.checksum += a_matcher.count_identical(the_simulated_gammas[ievent], the_reconstructed_gammas[ievent]);
+      }
+      a_matching.seconds = elapsed(a_start);
+    }
+
+    // Histogram filling, as done by the module for every event
+    timing_type a_filling = {"histograms", 0., 0};
+    mygsl::histogram_pool a_pool;
+    build_histogram_pool(a_pool);
+    analysis::histogram_registry the_histograms;
+    the_histograms.initialize(a_pool);
+    {
+      const clock_type::time_point a_start = clock_type::now();
+      for (const auto & ievent : the_events) {
+        the_histograms.get(analysis::histogram_registry::NUMBER_OF_GAMMA_CALOS).fill(ievent.channels.size());
+        the_histograms.get(analysis::histogram_registry::NUMBER_OF_GAMMAS).fill(ngammas_);
+        double a_total_energy = 0.;
+        for (auto ienergy : ievent.energies) a_total_energy += ienergy;
+        the_histograms.get(analysis::histogram_registry::TOTAL_GAMMA_ENERGY).fill(a_total_energy);
+        the_histograms.get(analysis::histogram_registry::GAMMA_ENERGY_MIN, ievent.channels.size() / ngammas_).fill(a_total_energy / ngammas_);
+        a_filling.checksum++;
+      }
+      a_filling.seconds = elapsed(a_start);
+    }
+
+    print_timing(a_legacy, nevents_, ntotal_hits);
+    print_timing(a_clustering, nevents_, ntotal_hits);
+    print_timing(a_matching, nevents_, ntotal_hits);
+    print_timing(a_filling, nevents_, ntotal_hits);
+    return;
+  }
+
+}
+
+int main(int argc_, char ** argv_)
+{
+  size_t nevents = 2000;
+  size_t ngammas = 3;
+  unsigned int seed = 314159;
+  std::vector<size_t> the_multiplicities = {1, 2, 5, 10, 20, 50, 100, 200, 400};
+
+  try {
+    for (int iarg = 1; iarg < argc_; iarg++) {
+      const std::string an_option = argv_[iarg];
+      if (an_option == "--help" || an_option == "-h") {
+        std::cout << "Usage: " << argv_[0] << " [--events N] [--hits N] [--gammas N] [--seed N]" << std::endl;
+        return 0;
+      }
+      if (iarg + 1 >= argc_) throw std::invalid_argument("Missing value for option '" + an_option + "'");
+      const unsigned long a_value = std::stoul(argv_[++iarg]);
+      if (an_option == "--events")      nevents = a_value;
+      else if (an_option == "--hits")   the_multiplicities.assign(1, a_value);
+      else if (an_option == "--gammas") ngammas = a_value;
+      else if (an_option == "--seed")   seed = a_value;
+      else throw std::invalid_argument("Unknown option '" + an_option + "'");
+    }
+    if (nevents == 0 || ngammas == 0 || ngammas > 10) {
+      throw std::invalid_argument("Number of events must be positive and number of gammas within [1;10]");
+    }
+
+    // Two main walls of 20 columns by 13 rows
+    const mock_neighbourhood a_grid(2, 20, 13);
+    for (auto inhits : the_multiplicities) {
+      if (inhits == 0 || inhits > a_grid.size()) {
+        throw std::invalid_argument("Number of hits must be within [1;" + std::to_string(a_grid.size()) + "]");
+      }
+    }
+
+    std::cout << "# " << nevents << " events, " << ngammas << " gammas, "
+              << a_grid.size() << " calorimeter channels" << std::endl;
+    std::cout << "#  hits  kernel            events/s      ns/hit    checksum" << std::endl;
+    for (auto inhits : the_multiplicities) {
+      run(a_grid, nevents, inhits, ngammas, seed);
+    }
+  } catch (std::exception & error_) {
+    std::cerr << "error: " << error_.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// end of snemo_gamma_tracking_efficiency_bench.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
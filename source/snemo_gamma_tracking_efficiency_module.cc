@@ -7,6 +7,8 @@
 #include <stdexcept>
 #include <sstream>
 #include <algorithm>
+#include <atomic>
+#include <exception>
 
 // Third party:
 // - Boost:
@@ -49,6 +51,51 @@ namespace analysis {
   // Character separator between key for histogram dict.
   const char KEY_FIELD_SEPARATOR = '_';
 
+  namespace {
+
+    static_assert(hit_table::INVALID_CHANNEL == calorimeter_channel_index::INVALID_CHANNEL,
+                  "Hit tables store unknown channels as the channel index does");
+
+    // Append the decimal digits of a number to a histogram key
+    unsigned int concatenate_key(unsigned int key_, unsigned int value_)
+    {
+      unsigned int a_shift = 10;
+      while (a_shift <= value_) a_shift *= 10;
+      return key_ * a_shift + value_;
+    }
+
+    // Kinds of sequence differences of an event, for the mismatch logs
+    std::string mismatch_kinds_summary(const gamma_sequence_matcher::match_type & match_)
+    {
+      std::ostringstream a_summary;
+      for (size_t i = 0; i < gamma_sequence_matcher::NUMBER_OF_MISMATCH_KINDS; i++) {
+        if (match_.kinds[i] == 0) continue;
+        a_summary << ", " << match_.kinds[i] << " "
+                  << gamma_sequence_matcher::get_mismatch_kind_name(static_cast<gamma_sequence_matcher::mismatch_kind>(i));
+      }
+      return a_summary.str();
+    }
+
+    // Prefix of the run state counters of a scanned time gap
+    std::string time_gap_scan_prefix(double gap_)
+    {
+      std::ostringstream a_prefix;
+      a_prefix << "time_gap_scan." << gap_ << "ns.";
+      return a_prefix.str();
+    }
+
+  }
+
+  const char * snemo_gamma_tracking_efficiency_module::get_binning_name(binning_id binning_)
+  {
+    switch (binning_) {
+    case BY_MULTIPLICITY: return "multiplicity";
+    case BY_ENERGY:       return "energy";
+    case BY_CALOS:        return "calos";
+    default:              return "";
+    }
+  }
+
   // Set the histogram pool used by the module :
   void snemo_gamma_tracking_efficiency_module::set_histogram_pool(mygsl::histogram_pool & pool_)
   {
@@ -70,11 +117,82 @@ namespace analysis {
   {
     _key_fields_.clear ();
 
+    _step_hit_categories_.assign(1, gamma_event_view::default_step_hit_category());
+
     _histogram_pool_ = 0;
 
-    _efficiency_ = {0, 0, 0, 0, 0, 0, 0};
+    _template_pool_.reset();
+
+    _locator_plugin_ = 0;
+
+    _channels_.reset();
+
+    _adjacency_.reset();
+
+    _unknown_channels_reported_ = false;
+
+    _transitive_clustering_ = false;
+
+    _check_clustering_ = false;
+
+    _time_gap_ = gamma_sequence_builder::DEFAULT_TIME_GAP;
+
+    _time_gap_scan_.clear();
+
+    _clustering_gaps_.clear();
+
+    _number_of_threads_ = 1;
+
+    _batch_size_ = 1;
+
+    _timing_.set_enabled(false);
+
+    _timing_.clear();
+
+    _timing_histograms_ = false;
+
+    _checkpoint_file_.clear();
+
+    _run_state_file_.clear();
 
-    _no_gt_efficiency_ = {0, 0};
+    _checkpoint_events_ = 0;
+
+    _checkpoint_seconds_ = 0;
+
+    _last_checkpoint_record_ = 0;
+
+    _checkpoint_warned_ = false;
+
+    _number_of_records_ = 0;
+
+    _number_of_resumed_records_ = 0;
+
+    _thread_shards_.clear();
+
+    _shards_.clear();
+
+    _efficiency_ = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    _no_gt_efficiency_ = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    _time_gap_scan_efficiency_.clear();
+
+    for (size_t i = 0; i < NUMBER_OF_BINNINGS; i++) {
+      _binned_efficiency_[i].reset();
+      _no_gt_binned_efficiency_[i].reset();
+    }
+
+    _confidence_level_ = 0.6827;
+
+    _mismatches_.clear();
+
+    _mismatches_.set_sampling(mismatch_report::DEFAULT_FIRST, mismatch_report::DEFAULT_EVERY);
+
+    _mismatch_histograms_ = false;
+
+    _track_length_ = false;
+
+    _prefilter_.reset();
 
     return;
   }
@@ -97,6 +215,211 @@ namespace analysis {
         config_.fetch("key_fields", _key_fields_);
       }
 
+    // Simulated calorimeter step hits: visualization tracks (default) or
+    // regular 'calo', 'xcalo' and 'gveto' hits with track id auxiliaries
+    if (config_.has_key("simulated.step_hit_categories"))
+      {
+        config_.fetch("simulated.step_hit_categories", _step_hit_categories_);
+        DT_THROW_IF(_step_hit_categories_.empty(), std::logic_error,
+                    "Module '" << get_name() << "' has no simulated step hit category !");
+      }
+
+    // Clustering mode
+    if (config_.has_key("clustering.transitive"))
+      {
+        _transitive_clustering_ = config_.fetch_boolean("clustering.transitive");
+      }
+    if (config_.has_key("clustering.check_legacy"))
+      {
+        _check_clustering_ = config_.fetch_boolean("clustering.check_legacy");
+      }
+    if (config_.has_key("clustering.time_gap"))
+      {
+        _time_gap_ = config_.fetch_real("clustering.time_gap");
+        DT_THROW_IF(_time_gap_ < 0, std::domain_error,
+                    "Module '" << get_name() << "' has an invalid clustering time gap (" << _time_gap_ << ") !");
+      }
+    if (config_.has_key("clustering.time_gap_scan"))
+      {
+        config_.fetch("clustering.time_gap_scan", _time_gap_scan_);
+        for (const auto igap : _time_gap_scan_) {
+          DT_THROW_IF(igap < 0, std::domain_error,
+                      "Module '" << get_name() << "' has an invalid scanned time gap (" << igap << ") !");
+        }
+      }
+    _clustering_gaps_.assign(1, _time_gap_);
+    _clustering_gaps_.insert(_clustering_gaps_.end(), _time_gap_scan_.begin(), _time_gap_scan_.end());
+    _time_gap_scan_efficiency_.assign(_time_gap_scan_.size(), {0, 0, 0, 0, 0, 0, 0, 0, 0});
+    DT_THROW_IF(_check_clustering_ && _transitive_clustering_, std::logic_error,
+                "Module '" << get_name() << "' can not check transitive clustering against legacy one !");
+
+    // Efficiencies binned by number of simulated gammas and of calibrated
+    // calorimeters (unit bins from 0) and by total gamma energy
+    int nmultiplicity_bins = 5;
+    int ncalos_bins = 20;
+    int nenergy_bins = 20;
+    double energy_min = 0.0;
+    double energy_max = 4.0 * CLHEP::MeV;
+    if (config_.has_key("binned.multiplicity.bins")) nmultiplicity_bins = config_.fetch_integer("binned.multiplicity.bins");
+    if (config_.has_key("binned.calos.bins")) ncalos_bins = config_.fetch_integer("binned.calos.bins");
+    if (config_.has_key("binned.energy.bins")) nenergy_bins = config_.fetch_integer("binned.energy.bins");
+    if (config_.has_key("binned.energy.min")) energy_min = config_.fetch_real("binned.energy.min");
+    if (config_.has_key("binned.energy.max")) energy_max = config_.fetch_real("binned.energy.max");
+    DT_THROW_IF(nmultiplicity_bins <= 0 || ncalos_bins <= 0 || nenergy_bins <= 0, std::domain_error,
+                "Module '" << get_name() << "' has an invalid number of efficiency bins !");
+    _binned_efficiency_[BY_MULTIPLICITY].initialize(nmultiplicity_bins, 0, nmultiplicity_bins);
+    _binned_efficiency_[BY_ENERGY].initialize(nenergy_bins, energy_min, energy_max);
+    _binned_efficiency_[BY_CALOS].initialize(ncalos_bins, 0, ncalos_bins);
+    for (size_t i = 0; i < NUMBER_OF_BINNINGS; i++) _no_gt_binned_efficiency_[i] = _binned_efficiency_[i];
+    if (config_.has_key("binned.confidence_level"))
+      {
+        _confidence_level_ = config_.fetch_real("binned.confidence_level");
+        DT_THROW_IF(_confidence_level_ <= 0 || _confidence_level_ >= 1, std::domain_error,
+                    "Module '" << get_name() << "' has an invalid confidence level (" << _confidence_level_ << ") !");
+      }
+
+    // Mismatches logging: the first ones, then one every 'report_every'
+    if (config_.has_key("mismatch.report_first") || config_.has_key("mismatch.report_every"))
+      {
+        int nfirst = mismatch_report::DEFAULT_FIRST;
+        int nevery = mismatch_report::DEFAULT_EVERY;
+        if (config_.has_key("mismatch.report_first")) nfirst = config_.fetch_integer("mismatch.report_first");
+        if (config_.has_key("mismatch.report_every")) nevery = config_.fetch_integer("mismatch.report_every");
+        DT_THROW_IF(nfirst < 0 || nevery < 0, std::domain_error,
+                    "Module '" << get_name() << "' has an invalid mismatch report sampling (" << nfirst << ", " << nevery << ") !");
+        _mismatches_.set_sampling(nfirst, nevery);
+      }
+    if (config_.has_key("mismatch.histograms"))
+      {
+        _mismatch_histograms_ = config_.fetch_boolean("mismatch.histograms");
+      }
+
+    // Comparison of the simulated and reconstructed gamma track lengths
+    if (config_.has_key("track_length.enabled"))
+      {
+        _track_length_ = config_.fetch_boolean("track_length.enabled");
+      }
+
+    // Event pre-filter, predicates are checked in the given order
+    if (config_.has_key("prefilter.predicates"))
+      {
+        std::vector<std::string> the_predicates;
+        config_.fetch("prefilter.predicates", the_predicates);
+        for (const auto & iname : the_predicates) {
+          _prefilter_.add_predicate(event_prefilter::get_predicate(iname));
+        }
+      }
+    const event_prefilter::predicate_id the_counting_predicates[3] = {event_prefilter::STEP_HITS,
+                                                                      event_prefilter::CALIBRATED_CALOS,
+                                                                      event_prefilter::GAMMAS};
+    for (const auto ipredicate : the_counting_predicates) {
+      const std::string a_key = std::string("prefilter.min_") + event_prefilter::get_predicate_name(ipredicate);
+      if (! config_.has_key(a_key)) continue;
+      const int a_minimum = config_.fetch_integer(a_key);
+      DT_THROW_IF(a_minimum < 0, std::domain_error,
+                  "Module '" << get_name() << "' has an invalid '" << a_key << "' (" << a_minimum << ") !");
+      _prefilter_.set_minimum(ipredicate, a_minimum);
+    }
+
+    // Number of worker threads
+    if (config_.has_key("processing.threads"))
+      {
+        const int nthreads = config_.fetch_integer("processing.threads");
+        DT_THROW_IF(nthreads < 1, std::domain_error,
+                    "Module '" << get_name() << "' has an invalid number of threads (" << nthreads << ") !");
+        _number_of_threads_ = nthreads;
+      }
+
+    // Number of records decoded before being analysed by 'process_records'
+    if (config_.has_key("processing.batch_size"))
+      {
+        const int nrecords = config_.fetch_integer("processing.batch_size");
+        DT_THROW_IF(nrecords < 1, std::domain_error,
+                    "Module '" << get_name() << "' has an invalid batch size (" << nrecords << ") !");
+        _batch_size_ = nrecords;
+      }
+
+    // Stage timing
+    if (config_.has_key("timing.enabled"))
+      {
+        _timing_.set_enabled(config_.fetch_boolean("timing.enabled"));
+      }
+    if (config_.has_key("timing.histograms"))
+      {
+        _timing_histograms_ = config_.fetch_boolean("timing.histograms");
+      }
+    // Latency histograms need the stage durations
+    if (_timing_histograms_) _timing_.set_enabled(true);
+
+    // Checkpointing
+    if (config_.has_key("checkpoint.file"))
+      {
+        _checkpoint_file_ = config_.fetch_string("checkpoint.file");
+        datatools::fetch_path_with_env(_checkpoint_file_);
+      }
+    if (config_.has_key("checkpoint.events"))
+      {
+        const int nevents = config_.fetch_integer("checkpoint.events");
+        DT_THROW_IF(nevents < 0, std::domain_error,
+                    "Module '" << get_name() << "' has an invalid checkpoint period (" << nevents << " events) !");
+        _checkpoint_events_ = nevents;
+      }
+    if (config_.has_key("checkpoint.seconds"))
+      {
+        _checkpoint_seconds_ = config_.fetch_real("checkpoint.seconds");
+        DT_THROW_IF(_checkpoint_seconds_ < 0, std::domain_error,
+                    "Module '" << get_name() << "' has an invalid checkpoint period (" << _checkpoint_seconds_ << " s) !");
+      }
+    DT_THROW_IF((_checkpoint_events_ > 0 || _checkpoint_seconds_ > 0) && _checkpoint_file_.empty(), std::logic_error,
+                "Module '" << get_name() << "' has a checkpoint period but no 'checkpoint.file' property !");
+
+    // State of a previous job to resume
+    std::string resume_file;
+    run_state a_resumed_state;
+    if (config_.has_key("resume_from"))
+      {
+        resume_file = config_.fetch_string("resume_from");
+        datatools::fetch_path_with_env(resume_file);
+        a_resumed_state.load(resume_file);
+      }
+
+    // Per event outcomes, appended to the ones stored up to the resumed checkpoint
+    if (config_.has_key("outcomes.file"))
+      {
+        std::string outcomes_file = config_.fetch_string("outcomes.file");
+        datatools::fetch_path_with_env(outcomes_file);
+        int block_rows = event_outcome_store::DEFAULT_BLOCK_ROWS;
+        if (config_.has_key("outcomes.block_rows"))
+          {
+            block_rows = config_.fetch_integer("outcomes.block_rows");
+            DT_THROW_IF(block_rows <= 0, std::domain_error,
+                        "Module '" << get_name() << "' has an invalid number of outcome rows per block (" << block_rows << ") !");
+          }
+        if (resume_file.empty())
+          {
+            _outcomes_.open(outcomes_file, block_rows);
+          }
+        else
+          {
+            DT_THROW_IF(! a_resumed_state.has_counter("checkpoint.outcome_blocks"), std::logic_error,
+                        "Module '" << get_name() << "' cannot append event outcomes to '" << outcomes_file
+                        << "' : '" << resume_file << "' is not a checkpoint of a job storing them !");
+            _outcomes_.resume(outcomes_file, block_rows, a_resumed_state.get_counter("checkpoint.outcome_blocks"));
+            DT_THROW_IF(_outcomes_.get_number_of_rows() != a_resumed_state.get_number_of_processed_events(),
+                        std::logic_error,
+                        "Module '" << get_name() << "' event outcomes file '" << outcomes_file << "' holds "
+                        << _outcomes_.get_number_of_rows() << " rows but '" << resume_file << "' has processed "
+                        << a_resumed_state.get_number_of_processed_events() << " event records !");
+          }
+      }
+
+    // Mergeable results of the job
+    if (config_.has_key("run_state.file"))
+      {
+        _run_state_file_ = config_.fetch_string("run_state.file");
+        datatools::fetch_path_with_env(_run_state_file_);
+      }
+
     // Service label
     std::string histogram_label;
     if (config_.has_key("Histo_label"))
@@ -136,7 +459,43 @@ namespace analysis {
               Histo.grab_pool().load(template_files[i]);
             }
           }
+      }
+
+    DT_THROW_IF(_track_length_ && ! _histogram_pool_->has_1d("delta_L_template"), std::logic_error,
+                "Module '" << get_name() << "' has no 'delta_L_template' histogram to compare gamma track lengths !");
 
+    // Keep a private copy of the templates to build worker threads histograms
+    _template_pool_.reset(new mygsl::histogram_pool);
+    _template_pool_->initialize(datatools::properties());
+    histogram_registry::copy_templates(*_histogram_pool_, *_template_pool_);
+
+    // Calorimeter channels and neighbourhood from the geometry cache, if it is valid
+    std::string geometry_cache_file;
+    geometry_cache a_geometry_cache;
+    if (config_.has_key("geometry_cache.file"))
+      {
+        geometry_cache_file = config_.fetch_string("geometry_cache.file");
+        datatools::fetch_path_with_env(geometry_cache_file);
+        DT_THROW_IF(! config_.has_key("geometry_cache.setup_label") ||
+                    ! config_.has_key("geometry_cache.setup_version"),
+                    std::logic_error,
+                    "Module '" << get_name() << "' has no geometry setup label and version to key the geometry cache !");
+        a_geometry_cache.set_setup(config_.fetch_string("geometry_cache.setup_label"),
+                                   config_.fetch_string("geometry_cache.setup_version"));
+        if (a_geometry_cache.load(geometry_cache_file, _channels_, _adjacency_))
+          {
+            DT_LOG_NOTICE(get_logging_priority(), "Calorimeter channels loaded from geometry cache '"
+                          << geometry_cache_file << "'");
+          }
+        else
+          {
+            DT_LOG_NOTICE(get_logging_priority(), "Geometry cache '" << geometry_cache_file
+                          << "' is missing or not valid, it is rebuilt from the geometry service");
+          }
+      }
+
+    if (! _channels_.is_initialized())
+      {
         // Geometry manager :
         std::string geo_label = snemo::processing::service_info::default_geometry_service_label();
         if (config_.has_key("Geo_label")) {
@@ -180,16 +539,131 @@ namespace analysis {
                      "Found no locator plugin named '" << locator_plugin_name << "'");
         _locator_plugin_ = &geo_mgr.get_plugin<snemo::geometry::locator_plugin> (locator_plugin_name);
 
-        // Tag the module as initialized :
-        _set_initialized(true);
-        return;
+        // Number calorimeter blocks and build their neighbourhood once for all
+        _channels_.initialize(geo_mgr, *_locator_plugin_);
+        _adjacency_.initialize(_channels_, *_locator_plugin_);
+
+        if (! geometry_cache_file.empty())
+          {
+            DT_THROW_IF(geo_mgr.get_setup_label() != a_geometry_cache.get_setup_label() ||
+                        geo_mgr.get_setup_version() != a_geometry_cache.get_setup_version(),
+                        std::logic_error,
+                        "Module '" << get_name() << "' geometry cache is keyed by setup '"
+                        << a_geometry_cache.get_setup_label() << "' version '" << a_geometry_cache.get_setup_version()
+                        << "' but the geometry service provides setup '" << geo_mgr.get_setup_label()
+                        << "' version '" << geo_mgr.get_setup_version() << "' !");
+            a_geometry_cache.store(geometry_cache_file, _channels_, _adjacency_);
+            DT_LOG_NOTICE(get_logging_priority(), "Geometry cache stored in '" << geometry_cache_file << "'");
+          }
+      }
+
+    DT_LOG_DEBUG(get_logging_priority(), "Number of calorimeter channels = " << _channels_.size());
+#ifdef ANALYSIS_BITSET_CALO_LIST
+    DT_THROW_IF(_channels_.size() > calorimeter_bitset::CAPACITY, std::range_error,
+                "Module '" << get_name() << "' has too many calorimeter channels (" << _channels_.size()
+                << ") for the bitset calorimeter list !");
+#endif
+
+    // Calorimeter hit tables for replay, with the neighbourhood they are clustered with
+    if (config_.has_key("hits.file"))
+      {
+        std::string hits_file = config_.fetch_string("hits.file");
+        datatools::fetch_path_with_env(hits_file);
+        hit_table::neighbourhood_type a_neighbourhood;
+        a_neighbourhood.offsets = _adjacency_.get_offsets();
+        a_neighbourhood.neighbours = _adjacency_.get_neighbours();
+        if (resume_file.empty())
+          {
+            _hit_tables_.create(hits_file, a_neighbourhood);
+          }
+        else
+          {
+            DT_THROW_IF(! a_resumed_state.has_counter("checkpoint.hit_tables")
+                        || ! a_resumed_state.has_counter("checkpoint.hit_table_size"), std::logic_error,
+                        "Module '" << get_name() << "' cannot append hit tables to '" << hits_file
+                        << "' : '" << resume_file << "' is not a checkpoint of a job storing them !");
+            _hit_tables_.resume(hits_file, a_neighbourhood,
+                                a_resumed_state.get_counter("checkpoint.hit_tables"),
+                                a_resumed_state.get_counter("checkpoint.hit_table_size"));
+          }
       }
+
+    // Restore the state of a previous job, its event records will be skipped
+    if (! resume_file.empty())
+      {
+        const run_state & a_state = a_resumed_state;
+        _efficiency_.import_counters(a_state, "efficiency.");
+        _no_gt_efficiency_.import_counters(a_state, "no_gt_efficiency.");
+        for (size_t igap = 0; igap < _time_gap_scan_.size(); igap++) {
+          const std::string a_prefix = time_gap_scan_prefix(_time_gap_scan_[igap]);
+          if (a_state.has_counter(a_prefix + "no_gt_nevent_gammas"))
+            _time_gap_scan_efficiency_[igap].import_counters(a_state, a_prefix);
+        }
+        _mismatches_.import_counters(a_state, "mismatch.");
+        _prefilter_.import_counters(a_state, "prefilter.");
+        for (size_t i = 0; i < NUMBER_OF_BINNINGS; i++) {
+          const std::string a_name = get_binning_name(static_cast<binning_id>(i));
+          _binned_efficiency_[i].import_counters(a_state, "binned_efficiency." + a_name + ".");
+          _no_gt_binned_efficiency_[i].import_counters(a_state, "no_gt_binned_efficiency." + a_name + ".");
+        }
+        a_state.fill_histograms(*_histogram_pool_);
+        _number_of_resumed_records_ = a_state.get_number_of_processed_events();
+        _last_checkpoint_record_ = _number_of_resumed_records_;
+        DT_LOG_NOTICE(get_logging_priority(),
+                      "Module '" << get_name() << "' resumes from '" << resume_file << "' after "
+                      << _number_of_resumed_records_ << " event records");
+      }
+    _last_checkpoint_time_ = std::chrono::steady_clock::now();
+
+    // The first processing state fills the module histogram pool
+    _add_shard();
+
+    // Tag the module as initialized :
+    _set_initialized(true);
+    return;
   }
   // Reset :
   void snemo_gamma_tracking_efficiency_module::reset()
   {
     DT_THROW_IF(! is_initialized(), std::logic_error,
                 "Module '" << get_name() << "' is not initialized !");
+    std::unique_lock<std::shared_timed_mutex> an_entry_lock(_entry_mutex_);
+
+    // Memory arenas usage
+    size_t nallocations = 0;
+    size_t nheap_allocations = 0;
+    size_t nreleases = 0;
+    for (const auto & ishard : _shards_) {
+      nallocations += ishard->arena.get_number_of_allocations();
+      nheap_allocations += ishard->arena.get_number_of_heap_allocations();
+      nreleases += ishard->arena.get_number_of_releases();
+    }
+    DT_LOG_NOTICE(get_logging_priority(),
+                  "Event arenas served " << nallocations << " allocations with " << nheap_allocations
+                  << " heap allocations for " << nreleases << " events");
+
+    // Gather worker threads results
+    _merge_shards();
+
+    // Final state of the job
+    if (! _checkpoint_file_.empty()) _store_checkpoint();
+    if (_outcomes_.is_open())
+      {
+        DT_LOG_NOTICE(get_logging_priority(), "Number of event outcomes stored = " << _outcomes_.get_number_of_rows());
+        _outcomes_.close();
+      }
+    if (_hit_tables_.is_open())
+      {
+        DT_LOG_NOTICE(get_logging_priority(), "Number of event hit tables stored = " << _hit_tables_.get_number_of_events());
+        _hit_tables_.close();
+      }
+    if (! _run_state_file_.empty())
+      {
+        run_state a_state;
+        _export_run_state(a_state);
+        a_state.store(_run_state_file_);
+        DT_LOG_NOTICE(get_logging_priority(), "Run state stored in '" << _run_state_file_ << "'");
+      }
 
     // Present results
     DT_LOG_NOTICE(get_logging_priority(),
@@ -214,6 +688,82 @@ namespace analysis {
                    "Number of events with gammas successfully clustered = " << _no_gt_efficiency_.no_gt_ngood_event << " / " << _no_gt_efficiency_.no_gt_nevent_gammas
                    << " ( " << _no_gt_efficiency_.no_gt_ngood_event/(double)_no_gt_efficiency_.no_gt_nevent_gammas*100 << " %)");
 
+    // Efficiency versus clustering time gap
+    for (size_t igap = 0; igap < _time_gap_scan_.size(); igap++) {
+      const efficiency_type & an_efficiency = _time_gap_scan_efficiency_[igap];
+      DT_LOG_NOTICE(get_logging_priority(),
+                    "Time gap " << _time_gap_scan_[igap] << " ns : number of events with gammas successfully clustered = "
+                    << an_efficiency.no_gt_ngood_event << " / " << an_efficiency.no_gt_nevent_gammas
+                    << " ( " << an_efficiency.no_gt_ngood_event/(double)an_efficiency.no_gt_nevent_gammas*100 << " %)");
+    }
+
+    // Events rejected by the pre-filter
+    for (const auto ipredicate : _prefilter_.get_predicates()) {
+      DT_LOG_NOTICE(get_logging_priority(),
+                    "Pre-filter '" << event_prefilter::get_predicate_name(ipredicate) << "' : "
+                    << _prefilter_.get_rejected(ipredicate) << " events rejected");
+    }
+
+    // Mismatches summary
+    for (size_t i = 0; i < mismatch_report::NUMBER_OF_CATEGORIES; i++) {
+      const mismatch_report::category_id a_category = static_cast<mismatch_report::category_id>(i);
+      if (_mismatches_.get_count(a_category) == 0) continue;
+      DT_LOG_NOTICE(get_logging_priority(),
+                    "Mismatch '" << mismatch_report::get_category_name(a_category) << "' : "
+                    << _mismatches_.get_count(a_category) << " events ("
+                    << _mismatches_.get_number_of_sampled(a_category) << " logged)");
+    }
+
+    for (size_t i = 0; i < gamma_sequence_matcher::NUMBER_OF_MISMATCH_KINDS; i++) {
+      const gamma_sequence_matcher::mismatch_kind a_kind = static_cast<gamma_sequence_matcher::mismatch_kind>(i);
+      DT_LOG_NOTICE(get_logging_priority(),
+                    "Sequence differences '" << gamma_sequence_matcher::get_mismatch_kind_name(a_kind) << "' : "
+                    << _mismatches_.get_kind_count(false, a_kind) << " with gamma tracking, "
+                    << _mismatches_.get_kind_count(true, a_kind) << " with clustering only");
+    }
+
+    // Binned efficiencies of the events with simulated gammas
+    for (size_t i = 0; i < NUMBER_OF_BINNINGS; i++) {
+      const binned_efficiency * the_efficiencies[2] = {&_binned_efficiency_[i], &_no_gt_binned_efficiency_[i]};
+      for (size_t itype = 0; itype < 2; itype++) {
+        const binned_efficiency & an_efficiency = *the_efficiencies[itype];
+        for (size_t ibin = 0; ibin < an_efficiency.get_number_of_bins() + 2; ibin++) {
+          const uint64_t ntotal = an_efficiency.get_total(ibin);
+          if (ntotal == 0) continue;
+          const uint64_t npassed = an_efficiency.get_passed(ibin);
+          const binned_efficiency::interval_type a_wilson
+            = binned_efficiency::wilson_interval(npassed, ntotal, _confidence_level_);
+          const binned_efficiency::interval_type a_clopper_pearson
+            = binned_efficiency::clopper_pearson_interval(npassed, ntotal, _confidence_level_);
+          DT_LOG_NOTICE(get_logging_priority(),
+                        (itype == 0 ? "Reconstruction" : "Clustering") << " efficiency by "
+                        << get_binning_name(static_cast<binning_id>(i)) << " in ["
+                        << an_efficiency.get_bin_low(ibin) << ", " << an_efficiency.get_bin_high(ibin) << ") = "
+                        << npassed << " / " << ntotal << " ( " << npassed/(double)ntotal*100 << " %), Wilson ["
+                        << a_wilson.low*100 << ", " << a_wilson.high*100 << "] %, Clopper-Pearson ["
+                        << a_clopper_pearson.low*100 << ", " << a_clopper_pearson.high*100 << "] % at "
+                        << _confidence_level_*100 << " % CL");
+        }
+      }
+    }
+
+    // Processing time per stage
+    if (_timing_.is_enabled())
+      {
+        for (size_t i = 0; i < stage_timing::NUMBER_OF_STAGES; i++) {
+          const stage_timing::stage_id a_stage = static_cast<stage_timing::stage_id>(i);
+          if (_timing_.get_number_of_calls(a_stage) == 0) continue;
+          DT_LOG_NOTICE(get_logging_priority(),
+                        "Stage '" << stage_timing::get_stage_name(a_stage) << "' : "
+                        << _timing_.get_number_of_calls(a_stage) << " calls, total = "
+                        << _timing_.get_total(a_stage) * 1e-6 << " ms, mean = "
+                        << _timing_.get_mean(a_stage) * 1e-3 << " us, p50/p90/p99 < "
+                        << _timing_.get_percentile(a_stage, 50) * 1e-3 << "/"
+                        << _timing_.get_percentile(a_stage, 90) * 1e-3 << "/"
+                        << _timing_.get_percentile(a_stage, 99) * 1e-3 << " us");
+        }
+      }
+
     // Tag the module as un-initialized :
     _set_initialized(false);
     _set_defaults();
@@ -235,6 +785,312 @@ namespace analysis {
     return;
   }
 
+  snemo_gamma_tracking_efficiency_module::shard_type & snemo_gamma_tracking_efficiency_module::_add_shard()
+  {
+    std::unique_ptr<shard_type> a_shard(new shard_type);
+    a_shard->efficiency = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+    a_shard->no_gt_efficiency = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+    a_shard->run_number = -1;
+    a_shard->event_number = -1;
+    a_shard->mismatch_kinds[0] = 0;
+    a_shard->mismatch_kinds[1] = 0;
+    a_shard->time_gap_scan.assign(_time_gap_scan_.size(), {0, 0, 0, 0, 0, 0, 0, 0, 0});
+    for (size_t i = 0; i < NUMBER_OF_BINNINGS; i++) {
+      a_shard->binned[i] = _binned_efficiency_[i];
+      a_shard->binned[i].clear();
+      a_shard->no_gt_binned[i] = _no_gt_binned_efficiency_[i];
+      a_shard->no_gt_binned[i].clear();
+    }
+    if (_shards_.empty())
+      {
+        a_shard->histograms.initialize(*_histogram_pool_);
+      }
+    else
+      {
+        a_shard->pool.reset(new mygsl::histogram_pool);
+        a_shard->pool->initialize(datatools::properties());
+        histogram_registry::copy_templates(*_template_pool_, *a_shard->pool);
+        a_shard->histograms.initialize(*a_shard->pool);
+      }
+    a_shard->event.initialize(_channels_, _step_hit_categories_);
+    if (_mismatch_histograms_)
+      {
+        mygsl::histogram_pool & a_pool = a_shard->pool ? *a_shard->pool : *_histogram_pool_;
+        const char * the_names[2] = {"gt_mismatch_kinds", "no_gt_mismatch_kinds"};
+        for (size_t i = 0; i < 2; i++) {
+          if (! a_pool.has(the_names[i]))
+            {
+              a_pool.add_1d(the_names[i], "", "mismatch").initialize(gamma_sequence_matcher::NUMBER_OF_MISMATCH_KINDS,
+                                                                     0., (double) gamma_sequence_matcher::NUMBER_OF_MISMATCH_KINDS);
+            }
+          a_shard->mismatch_kinds[i] = &a_pool.grab_1d(the_names[i]);
+        }
+      }
+    a_shard->timing.set_enabled(_timing_.is_enabled());
+    if (_timing_histograms_)
+      {
+        a_shard->timing.set_histogram_pool(a_shard->pool ? *a_shard->pool : *_histogram_pool_);
+      }
+    a_shard->sequences.initialize(_adjacency_.get_number_of_channels(),
+                                  _adjacency_.get_offsets().data(),
+                                  _adjacency_.get_neighbours().data(),
+                                  _transitive_clustering_);
+    a_shard->sequences.set_time_gap(_time_gap_);
+    if (_outcomes_.is_open()) a_shard->outcomes.set_capacity(_outcomes_.get_block_rows());
+    if (_hit_tables_.is_open()) a_shard->channel_truths.assign(_channels_.size(), 0);
+    _shards_.push_back(std::move(a_shard));
+    return *_shards_.back();
+  }
+
+  snemo_gamma_tracking_efficiency_module::shard_type & snemo_gamma_tracking_efficiency_module::_grab_shard()
+  {
+    std::lock_guard<std::mutex> lock(_shards_mutex_);
+    const std::thread::id a_thread = std::this_thread::get_id();
+    auto found = _thread_shards_.find(a_thread);
+    if (found != _thread_shards_.end()) return *found->second;
+
+    // The first thread gets the processing state created at initialization
+    shard_type & a_shard = _thread_shards_.empty() ? *_shards_.front() : _add_shard();
+    _thread_shards_[a_thread] = &a_shard;
+    return a_shard;
+  }
+
+  snemo_gamma_tracking_efficiency_module::shard_type & snemo_gamma_tracking_efficiency_module::_grab_worker_shard(size_t ithread_)
+  {
+    std::lock_guard<std::mutex> lock(_shards_mutex_);
+    // The first worker gets the processing state created at initialization,
+    // the other ones are kept from one call to the other until merged. States
+    // bound to other threads may be reused, as their 'process' calls are over
+    while (_shards_.size() <= ithread_) _add_shard();
+    return *_shards_[ithread_];
+  }
+
+  void snemo_gamma_tracking_efficiency_module::_merge_shards()
+  {
+    // Shards are merged in creation order; counters are integers and
+    // histograms are filled with unit weights so that the result does not
+    // depend on how events have been dispatched among threads
+    for (const auto & ishard : _shards_) {
+      _efficiency_.merge(ishard->efficiency);
+      _no_gt_efficiency_.merge(ishard->no_gt_efficiency);
+      _timing_.merge(ishard->timing);
+      ishard->timing.clear();
+      ishard->efficiency = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+      ishard->no_gt_efficiency = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+      for (size_t igap = 0; igap < _time_gap_scan_.size(); igap++) {
+        _time_gap_scan_efficiency_[igap].merge(ishard->time_gap_scan[igap]);
+        ishard->time_gap_scan[igap] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+      }
+      for (size_t i = 0; i < NUMBER_OF_BINNINGS; i++) {
+        _binned_efficiency_[i].merge(ishard->binned[i]);
+        ishard->binned[i].clear();
+        _no_gt_binned_efficiency_[i].merge(ishard->no_gt_binned[i]);
+        ishard->no_gt_binned[i].clear();
+      }
+      if (ishard->pool) histogram_registry::merge(*ishard->pool, *_histogram_pool_);
+      if (_outcomes_.is_open()) _outcomes_.write(ishard->outcomes);
+    }
+    // Worker thread states are rebuilt on demand
+    _shards_.resize(1);
+    _thread_shards_.clear();
+    return;
+  }
+
+  void snemo_gamma_tracking_efficiency_module::process_records(const std::vector<datatools::things *> & records_,
+                                                               std::vector<process_status> & statuses_)
+  {
+    DT_THROW_IF(! is_initialized(), std::logic_error,
+                "Module '" << get_name() << "' is not initialized !");
+
+    // Worker threads take the processing states of the other threads
+    std::unique_lock<std::shared_timed_mutex> an_entry_lock(_entry_mutex_);
+    statuses_.assign(records_.size(), dpp::base_module::PROCESS_ERROR);
+    const uint64_t first_record = _number_of_records_.fetch_add(records_.size());
+    std::atomic<size_t> next_record(0);
+    std::vector<std::exception_ptr> the_errors(_number_of_threads_);
+
+    auto a_worker = [&] (size_t ithread_) {
+      try {
+        shard_type & a_shard = _grab_worker_shard(ithread_);
+        for (size_t irecord = next_record.fetch_add(_batch_size_); irecord < records_.size();
+             irecord = next_record.fetch_add(_batch_size_)) {
+          const size_t nrecords = std::min(_batch_size_, records_.size() - irecord);
+          _process_batch(records_.data() + irecord, nrecords, first_record + irecord, &statuses_[irecord], a_shard);
+        }
+      } catch (...) {
+        the_errors[ithread_] = std::current_exception();
+        next_record = records_.size();
+      }
+    };
+
+    std::vector<std::thread> the_threads;
+    for (size_t ithread = 0; ithread < _number_of_threads_; ithread++) {
+      the_threads.push_back(std::thread(a_worker, ithread));
+    }
+    for (auto & ithread : the_threads) ithread.join();
+
+    for (const auto & ierror : the_errors) {
+      if (ierror) std::rethrow_exception(ierror);
+    }
+
+    // Worker threads are done, their states can be merged
+    _update_checkpoint(true);
+    return;
+  }
+
+  void snemo_gamma_tracking_efficiency_module::process_batch(datatools::things * const * records_,
+                                                             size_t nrecords_,
+                                                             process_status * statuses_)
+  {
+    DT_THROW_IF(! is_initialized(), std::logic_error,
+                "Module '" << get_name() << "' is not initialized !");
+
+    std::shared_lock<std::shared_timed_mutex> an_entry_lock(_entry_mutex_);
+    const uint64_t first_record = _number_of_records_.fetch_add(nrecords_);
+    _process_batch(records_, nrecords_, first_record, statuses_, _grab_shard());
+    _update_checkpoint(false);
+    return;
+  }
+
+  void snemo_gamma_tracking_efficiency_module::_update_checkpoint(bool quiescent_)
+  {
+    if (_checkpoint_events_ == 0 && _checkpoint_seconds_ == 0) return;
+
+    std::unique_lock<std::mutex> lock(_shards_mutex_, std::defer_lock);
+    if (! quiescent_)
+      {
+        // Only a single thread calling 'process' guarantees that the
+        // processing states are not in use while being merged
+        lock.lock();
+        if (_thread_shards_.size() > 1)
+          {
+            if (! _checkpoint_warned_)
+              DT_LOG_WARNING(get_logging_priority(),
+                             "Module '" << get_name() << "' is processed by several threads, "
+                             << "checkpoints are only stored by 'process_records' and 'reset' !");
+            _checkpoint_warned_ = true;
+            return;
+          }
+      }
+
+    bool due = _checkpoint_events_ > 0 && _number_of_records_ - _last_checkpoint_record_ >= _checkpoint_events_;
+    if (! due && _checkpoint_seconds_ > 0)
+      {
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - _last_checkpoint_time_;
+        due = elapsed.count() >= _checkpoint_seconds_;
+      }
+    if (due) _store_checkpoint();
+    return;
+  }
+
+  void snemo_gamma_tracking_efficiency_module::_store_checkpoint()
+  {
+    _merge_shards();
+
+    run_state a_state;
+    _export_run_state(a_state);
+    // Where the outcome and hit table files end, for a resumed job to append to them
+    if (_outcomes_.is_open())
+      {
+        a_state.set_counter("checkpoint.outcome_blocks", _outcomes_.get_number_of_blocks());
+      }
+    if (_hit_tables_.is_open())
+      {
+        a_state.set_counter("checkpoint.hit_tables", _hit_tables_.get_number_of_events());
+        a_state.set_counter("checkpoint.hit_table_size", _hit_tables_.flush());
+      }
+    a_state.store(_checkpoint_file_);
+
+    _last_checkpoint_record_ = a_state.get_number_of_processed_events();
+    _last_checkpoint_time_ = std::chrono::steady_clock::now();
+    DT_LOG_INFORMATION(get_logging_priority(),
+                       "Checkpoint stored in '" << _checkpoint_file_ << "' after " << _last_checkpoint_record_ << " event records");
+    return;
+  }
+
+  void snemo_gamma_tracking_efficiency_module::_record_outcome(const event_outcome_store::row_type & outcome_,
+                                                               shard_type & shard_)
+  {
+    if (! _outcomes_.is_open()) return;
+    shard_.outcomes.push_back(outcome_);
+    if (shard_.outcomes.is_full()) _outcomes_.write(shard_.outcomes);
+    return;
+  }
+
+  void snemo_gamma_tracking_efficiency_module::_store_hit_table(const gamma_event_view & event_,
+                                                                shard_type & shard_)
+  {
+    if (! _hit_tables_.is_open()) return;
+    hit_table::event_type & a_table = shard_.hits;
+    a_table.clear();
+    if (event_.eh)
+      {
+        a_table.run_number = event_.eh->get_id().get_run_number();
+        a_table.event_number = event_.eh->get_id().get_event_number();
+      }
+    if (event_.sd) a_table.flags |= hit_table::HAS_SIMULATED_DATA;
+    if (event_.cd) a_table.flags |= hit_table::HAS_CALIBRATED_DATA;
+    if (event_.ptd) a_table.flags |= hit_table::HAS_PARTICLE_TRACK_DATA;
+    if (event_.has_step_hits) a_table.flags |= hit_table::HAS_STEP_HITS;
+    a_table.number_of_primary_gammas = event_.number_of_primary_gammas;
+    a_table.number_of_calibrated_hits = event_.calibrated_channels.size();
+    a_table.number_of_step_hits = event_.step_channels.size();
+    a_table.gamma_track_ids.assign(event_.gamma_track_ids.begin(), event_.gamma_track_ids.end());
+
+    // Only the first non zero primary track id of a channel matters to the
+    // simulated sequences, step hits are summarized by it
+    for (auto ichannel : shard_.touched_channels) shard_.channel_truths[ichannel] = 0;
+    shard_.touched_channels.clear();
+    for (size_t ihit = 0; ihit < event_.step_channels.size(); ihit++) {
+      const int track_id = event_.step_track_ids[ihit];
+      const channel_type a_channel = event_.step_channels[ihit];
+      if (track_id == 0 || a_channel == calorimeter_channel_index::INVALID_CHANNEL) continue;
+      if (shard_.channel_truths[a_channel] != 0) continue;
+      shard_.channel_truths[a_channel] = track_id;
+      shard_.touched_channels.push_back(a_channel);
+    }
+
+    // Hits of the reconstructed gammas, then the other calibrated hits
+    // (hits of unknown blocks are kept as isolated clusters)
+    for (size_t ihit = 0; ihit < event_.get_number_of_hits(); ihit++) {
+      const channel_type a_channel = event_.hit_channels[ihit];
+      const int a_truth = a_channel == calorimeter_channel_index::INVALID_CHANNEL ? 0 : shard_.channel_truths[a_channel];
+      a_table.push_back(a_channel, event_.hit_gammas[ihit], a_truth,
+                        event_.hit_times[ihit], event_.hit_energies[ihit]);
+    }
+    a_table.number_of_gamma_hits = a_table.size();
+    for (size_t ihit = 0; ihit < event_.calibrated_channels.size(); ihit++) {
+      const channel_type a_channel = event_.calibrated_channels[ihit];
+      if (a_channel == calorimeter_channel_index::INVALID_CHANNEL) continue;
+      if (std::find(a_table.channels.begin(), a_table.channels.begin() + a_table.number_of_gamma_hits, a_channel)
+          != a_table.channels.begin() + a_table.number_of_gamma_hits) continue;
+      a_table.push_back(a_channel, hit_table::NO_GAMMA, shard_.channel_truths[a_channel],
+                        event_.calibrated_times[ihit], event_.calibrated_energies[ihit]);
+    }
+
+    _hit_tables_.write(a_table);
+    return;
+  }
+
+  void snemo_gamma_tracking_efficiency_module::_export_run_state(run_state & state_) const
+  {
+    state_.set_number_of_processed_events(std::max<uint64_t>(_number_of_records_, _number_of_resumed_records_));
+    _efficiency_.export_counters(state_, "efficiency.");
+    _no_gt_efficiency_.export_counters(state_, "no_gt_efficiency.");
+    for (size_t igap = 0; igap < _time_gap_scan_.size(); igap++) {
+      _time_gap_scan_efficiency_[igap].export_counters(state_, time_gap_scan_prefix(_time_gap_scan_[igap]));
+    }
+    _mismatches_.export_counters(state_, "mismatch.");
+    _prefilter_.export_counters(state_, "prefilter.");
+    for (size_t i = 0; i < NUMBER_OF_BINNINGS; i++) {
+      const std::string a_name = get_binning_name(static_cast<binning_id>(i));
+      _binned_efficiency_[i].export_counters(state_, "binned_efficiency." + a_name + ".");
+      _no_gt_binned_efficiency_[i].export_counters(state_, "no_gt_binned_efficiency." + a_name + ".");
+    }
+    state_.add_histograms(*_histogram_pool_);
+    return;
+  }
+
   // Explore the cluster
   void snemo_gamma_tracking_efficiency_module::get_new_neighbours(geomtools::geom_id gid,
                                                                   const snemo::datamodel::calibrated_data::calorimeter_hit_collection_type & cch,
@@ -246,80 +1102,58 @@ namespace analysis {
     else
       return;
 
-    std::vector<geomtools::geom_id>  the_neighbours = {};
     std::vector<geomtools::geom_id>  the_calib_neighbours = {};
 
-    const snemo::geometry::calo_locator & calo_locator
-      = _locator_plugin_->get_calo_locator();
-    const snemo::geometry::xcalo_locator & xcalo_locator
-      = _locator_plugin_->get_xcalo_locator();
-    const snemo::geometry::gveto_locator & gveto_locator
-      = _locator_plugin_->get_gveto_locator();
-
-    if (calo_locator.is_calo_block_in_current_module(gid))
-      calo_locator.get_neighbours_ids(gid, the_neighbours, snemo::geometry::utils::NEIGHBOUR_FIRST);
-
-    if (xcalo_locator.is_calo_block_in_current_module(gid))
-      xcalo_locator.get_neighbours_ids(gid, the_neighbours, snemo::geometry::utils::NEIGHBOUR_FIRST);
-
-    if (gveto_locator.is_calo_block_in_current_module(gid))
-      gveto_locator.get_neighbours_ids(gid, the_neighbours, snemo::geometry::utils::NEIGHBOUR_FIRST);
+    // Neighbours are read from the table built at initialization
+    const channel_type channel = _channels_.get_channel(gid);
+    if (channel == calorimeter_channel_index::INVALID_CHANNEL) {
+      DT_LOG_DEBUG(get_logging_priority(), "Calorimeter " << gid << " is not part of the current module !");
+      return;
+    }
 
-    for (auto ineighbour : the_neighbours)
-      if (std::find_if(cch.begin(), cch.end(), [ineighbour] (auto icalo)
+    for (const calorimeter_adjacency::channel_type * ichannel = _adjacency_.neighbours_begin(channel);
+         ichannel != _adjacency_.neighbours_end(channel); ichannel++) {
+      const geomtools::geom_id & ineighbour = _channels_.get_geom_id(*ichannel);
+      if (std::find_if(cch.begin(), cch.end(), [&ineighbour] (const auto & icalo)
                        {return ineighbour == icalo.get().get_geom_id();}) != cch.end())
         if(std::find(ccl.begin(), ccl.end(), ineighbour)==ccl.end()) {
           the_calib_neighbours.push_back(ineighbour);
           ccl.push_back(ineighbour);
           a_cluster.push_back(ineighbour);
         }
+    }
 
     for(auto i_calib_neighbour : the_calib_neighbours)
       get_new_neighbours(i_calib_neighbour, cch, ccl, a_cluster);
-  }
-
-  // Pre processing for cluster identification
-  void snemo_gamma_tracking_efficiency_module::_pre_process_clustering(const datatools::things & data_record_,
-                                                                       gamma_dict_type & clustered_gammas_)
-  {
-    // // Check if some 'calibrated_data' are available in the data model:
-    // const std::string cd_label = snemo::datamodel::data_info::default_calibrated_data_label();
-    // if (! data_record_.has(cd_label)) {
-    //   DT_LOG_ERROR(get_logging_priority(), "Missing calibrated data to be processed !");
-    // }
-
-    // // Get the 'calibrated_data' entry from the data model :
-    // const snemo::datamodel::calibrated_data & cd
-    //   = data_record_.get<snemo::datamodel::calibrated_data>(cd_label);
-
-    // Check if some 'particle_track_data' are available in the data model:
-    const std::string ptd_label = snemo::datamodel::data_info::default_particle_track_data_label();
-    if (! data_record_.has(ptd_label)) {
-      DT_LOG_ERROR(get_logging_priority(), "Missing particle track data to be processed !");
-    }
-
-    // Get the 'particle_track_data' entry from the data model :
-    const snemo::datamodel::particle_track_data & ptd
-      = data_record_.get<snemo::datamodel::particle_track_data>(ptd_label);
-
-    snemo::datamodel::particle_track_data::particle_collection_type gamma_particles;
-    ptd.fetch_particles(gamma_particles, snemo::datamodel::particle_track::NEUTRAL);
+  }
 
-    // retrieve only hits from gammas
-    snemo::datamodel::calibrated_calorimeter_hit::collection_type cch;
+  void snemo_gamma_tracking_efficiency_module::_report_unknown_channels(size_t nunknown_)
+  {
+    if (_unknown_channels_reported_.exchange(true)) return;
+    DT_LOG_WARNING(get_logging_priority(), "Module '" << get_name() << "' found " << nunknown_
+                   << " calorimeter hits without channel in an event, they are clustered alone "
+                   << "and left out of the reconstructed sequences (reported once) !");
+    return;
+  }
 
-    for(auto igamma : gamma_particles) {
-      snemo::datamodel::particle_track a_gamma = igamma.grab();
-      cch.insert(cch.end(),a_gamma.get_associated_calorimeter_hits().begin(),a_gamma.get_associated_calorimeter_hits().end());
+  void snemo_gamma_tracking_efficiency_module::_check_clustering(const gamma_event_view & event_,
+                                                                 const shard_type & shard_)
+  {
+    snemo::datamodel::calibrated_data::calorimeter_hit_collection_type cch;
+    for (const auto & ihandle : event_.hit_handles) cch.push_back(*ihandle);
+
+    const calorimeter_clustering & a_clustering = shard_.sequences.get_clustering();
+    std::vector<std::vector<geomtools::geom_id> >  the_clusters(a_clustering.get_number_of_clusters());
+    for (size_t icluster = 0; icluster < the_clusters.size(); icluster++) {
+      for (const calorimeter_clustering::hit_index_type * ihit = a_clustering.cluster_begin(icluster);
+           ihit != a_clustering.cluster_end(icluster); ihit++) {
+        the_clusters[icluster].push_back(event_.hit_handles[*ihit]->get().get_geom_id());
+      }
     }
 
-    // std::cout << " cch size " << cch.size() << std::endl;
-
     std::vector<geomtools::geom_id>  ccl = {};
 
-    size_t number_of_clusters = 0;
-
-    std::vector<std::vector<geomtools::geom_id> >  the_reconstructed_clusters;
+    std::vector<std::vector<geomtools::geom_id> >  the_legacy_clusters;
 
     for (auto icalo : cch) {
 
@@ -333,520 +1167,334 @@ namespace analysis {
 
       get_new_neighbours(gid, cch, ccl, a_cluster);
 
-      the_reconstructed_clusters.push_back(a_cluster);
-
-      number_of_clusters++;
-    }
-
-    std::vector<std::map<double, geomtools::geom_id> >  the_ordered_reconstructed_clusters;
-
-    for(auto icluster : the_reconstructed_clusters)
-      {
-        std::map<double,geomtools::geom_id> a_cluster = {};
-
-       for(auto igid : icluster)
-          for(auto ihit : cch)
-            if(igid == ihit.get().get_geom_id())
-                a_cluster.insert( std::pair<double,geomtools::geom_id >(ihit.get().get_time(),igid) );
-
-       the_ordered_reconstructed_clusters.push_back(a_cluster);
-      }
-
-    std::sort(the_ordered_reconstructed_clusters.begin(), the_ordered_reconstructed_clusters.end());
-
-    int track_id = 0;
-
-    for(auto icluster : the_ordered_reconstructed_clusters)
-      {
-        track_id++;
-
-        if(icluster.size() < 2)
-          {
-            for (auto ipair : icluster)
-              clustered_gammas_[track_id].insert(ipair.second);
-            continue;
-          }
-
-        double t0 = 0; // not ideal
-        double t1 = 0;
-
-        for (auto ipair : icluster)
-          {
-            t0 = t1;
-            t1 = ipair.first;
-            // std::cout << " " << ipair.first  << "   " << std::next(&ipair)->first << std::endl;
-            // std::cout << " " << t0  << "   " << t1 << std::endl;
-
-            if(t0!=0 && t1!=0 && t1-t0 > 2.5 /*ns*/)
-              {
-                number_of_clusters++;
-                track_id++;
-              }
-
-            clustered_gammas_[track_id].insert(ipair.second);
-          }
-      }
-
-    // Check if some 'event_header' are available in the data model:
-    const std::string eh_label = snemo::datamodel::data_info::default_event_header_label();
-    if (! data_record_.has(eh_label)) {
-      DT_LOG_ERROR(get_logging_priority(), "Missing event header info !");
+      the_legacy_clusters.push_back(a_cluster);
     }
 
-    // Get the 'event_header' entry from the data model :
-    const snemo::datamodel::event_header & eh
-      = data_record_.get<snemo::datamodel::event_header>(eh_label);
-
-    // if(number_of_clusters == 4)
-    //   std::cout << eh.get_id() << std::endl;
-
-    // Build unique key for histogram map:
-    std::ostringstream key;
-    key << "number_of_gamma_calos";
-
-    // Getting histogram pool
-    mygsl::histogram_pool & a_pool = grab_histogram_pool();
-
-    if (! a_pool.has(key.str()))
-      {
-        mygsl::histogram_1d & h = a_pool.add_1d(key.str(), "", "number_of_gamma_calos");
-        datatools::properties hconfig;
-        hconfig.store_string("mode", "mimic");
-        hconfig.store_string("mimic.histogram_1d", "number_of_calos_template");
-        mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-      }
-
-    // Getting the current histogram
-    mygsl::histogram_1d & a_histo_gamma_calos = a_pool.grab_1d(key.str ());
-    a_histo_gamma_calos.fill(cch.size());
-
-    key.str("");
-    key.clear();
-
-    // // Build unique key for histogram map:
-    // std::ostringstream key;
-    key << "number_of_gamma_clusters";
+    DT_THROW_IF(the_legacy_clusters != the_clusters, std::logic_error,
+                "Clustering engine and legacy clustering disagree ("
+                << the_clusters.size() << " vs. " << the_legacy_clusters.size() << " clusters) !");
+    return;
+  }
 
-    // // Getting histogram pool
-    // mygsl::histogram_pool & a_pool = grab_histogram_pool();
+  // Pre processing for cluster identification
+  void snemo_gamma_tracking_efficiency_module::_pre_process_clustering(const gamma_event_view & event_,
+                                                                       gamma_dict_type * clustered_gammas_,
+                                                                       shard_type & shard_)
+  {
+    DT_THROW_IF(! event_.ptd, std::logic_error, "Missing particle track data to be processed !");
+
+    // Hits of unknown blocks are kept, as isolated clusters
+    const size_t nunknown = std::count(event_.hit_channels.begin(), event_.hit_channels.end(),
+                                       calorimeter_channel_index::INVALID_CHANNEL);
+    if (nunknown > 0) _report_unknown_channels(nunknown);
+
+    // Scanned time gaps share the clustering and the time ordering
+    shard_.gap_clusters.resize(_clustering_gaps_.size());
+    shard_.sequences.build_clustered(event_.hit_channels.data(),
+                                     event_.hit_times.data(),
+                                     event_.get_number_of_hits(),
+                                     _clustering_gaps_.data(),
+                                     _clustering_gaps_.size(),
+                                     clustered_gammas_,
+                                     shard_.gap_clusters.data());
+    const size_t number_of_clusters = shard_.gap_clusters.front();
+
+    if (_check_clustering_) _check_clustering(event_, shard_);
+
+    shard_.histograms.get(histogram_registry::NUMBER_OF_GAMMA_CALOS).fill(event_.get_number_of_hits());
+    shard_.histograms.get(histogram_registry::NUMBER_OF_GAMMA_CLUSTERS).fill(number_of_clusters);
+
+    mygsl::histogram_1d & a_histo_clusters_size = shard_.histograms.get(histogram_registry::CLUSTERS_SIZE);
+    for (const auto & igamma : clustered_gammas_[0])
+        a_histo_clusters_size.fill(igamma.second.size());
 
-    if (! a_pool.has(key.str()))
-      {
-        mygsl::histogram_1d & h = a_pool.add_1d(key.str(), "", "number_of_gamma_clusters");
-        datatools::properties hconfig;
-        hconfig.store_string("mode", "mimic");
-        hconfig.store_string("mimic.histogram_1d", "number_of_calos_template");
-        mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-      }
+    // shard_.no_gt_efficiency.no_gt_ngood_event++;
 
-    // Getting the current histogram
-    mygsl::histogram_1d & a_histo_gamma_clusters = a_pool.grab_1d(key.str ());
-    a_histo_gamma_clusters.fill(number_of_clusters);
+  }
 
-        key.str("");
-    key.clear();
+// Processing :
+dpp::base_module::process_status snemo_gamma_tracking_efficiency_module::process(datatools::things & data_record_)
+{
+  DT_LOG_TRACE(get_logging_priority(), "Entering...");
+  DT_THROW_IF(! is_initialized(), std::logic_error,
+              "Module '" << get_name() << "' is not initialized !");
 
-    // // Build unique key for histogram map:
-    // std::ostringstream key;
-    key << "clusters_size";
+  std::shared_lock<std::shared_timed_mutex> an_entry_lock(_entry_mutex_);
+  const process_status status = _process_record(data_record_, _number_of_records_++);
+  _update_checkpoint(false);
 
-    // // Getting histogram pool
-    // mygsl::histogram_pool & a_pool = grab_histogram_pool();
+  DT_LOG_TRACE(get_logging_priority(), "Exiting.");
+  return status;
+}
 
-    if (! a_pool.has(key.str()))
-      {
-        mygsl::histogram_1d & h = a_pool.add_1d(key.str(), "", "clusters_size");
-        datatools::properties hconfig;
-        hconfig.store_string("mode", "mimic");
-        hconfig.store_string("mimic.histogram_1d", "number_of_calos_template");
-        mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-      }
+dpp::base_module::process_status snemo_gamma_tracking_efficiency_module::_process_record(datatools::things & data_record_,
+                                                                                         uint64_t record_)
+{
+  // Already accounted for by the resumed job
+  if (record_ < _number_of_resumed_records_) return dpp::base_module::PROCESS_STOP;
 
-    // Getting the current histogram
-    mygsl::histogram_1d & a_histo_clusters_size = a_pool.grab_1d(key.str ());
+   // std::cout << " ---------------------------------------------------------------------------------- " << std::endl;
 
-    for (auto igamma : clustered_gammas_)
-        a_histo_clusters_size.fill(igamma.second.size());
+  shard_type & a_shard = _grab_shard();
+  stage_timing::scope an_event_timer(a_shard.timing, stage_timing::EVENT);
+  const bool accepted = _extract_record(data_record_, a_shard.event, a_shard);
+  return _analyse_event(a_shard.event, accepted, a_shard);
+}
 
-    // _no_gt_efficiency_.no_gt_ngood_event++;
+bool snemo_gamma_tracking_efficiency_module::_extract_record(const datatools::things & data_record_,
+                                                             gamma_event_view & event_,
+                                                             shard_type & shard_)
+{
+  // Decode the event once for all the analysis stages, unless the
+  // pre-filter rejects it from the content of its banks
+  stage_timing::scope a_timer(shard_.timing, stage_timing::EXTRACTION);
+  event_.lookup(data_record_);
+  if (_prefilter_.is_enabled() && ! _prefilter_.accept(event_)) return false;
+  event_.decode();
+  return true;
+}
 
+void snemo_gamma_tracking_efficiency_module::_process_batch(datatools::things * const * records_,
+                                                            size_t nrecords_,
+                                                            uint64_t first_record_,
+                                                            process_status * statuses_,
+                                                            shard_type & shard_)
+{
+  // All the records are decoded first, the analysis stages then run back
+  // to back over events whose tables are still in cache
+  while (shard_.batch_events.size() < nrecords_) {
+    shard_.batch_events.emplace_back(new gamma_event_view);
+    shard_.batch_events.back()->initialize(_channels_, _step_hit_categories_);
+  }
+  shard_.batch_accepted.assign(nrecords_, false);
+  for (size_t irecord = 0; irecord < nrecords_; irecord++) {
+    // Already accounted for by the resumed job
+    statuses_[irecord] = dpp::base_module::PROCESS_STOP;
+    if (first_record_ + irecord < _number_of_resumed_records_) continue;
+    shard_.batch_accepted[irecord] = _extract_record(*records_[irecord], *shard_.batch_events[irecord], shard_);
   }
+  for (size_t irecord = 0; irecord < nrecords_; irecord++) {
+    if (first_record_ + irecord < _number_of_resumed_records_) continue;
+    stage_timing::scope an_event_timer(shard_.timing, stage_timing::EVENT);
+    statuses_[irecord] = _analyse_event(*shard_.batch_events[irecord], shard_.batch_accepted[irecord], shard_);
+  }
+  return;
+}
 
-// Processing :
-dpp::base_module::process_status snemo_gamma_tracking_efficiency_module::process(datatools::things & data_record_)
+dpp::base_module::process_status snemo_gamma_tracking_efficiency_module::_analyse_event(const gamma_event_view & event_,
+                                                                                        bool accepted_,
+                                                                                        shard_type & shard_)
 {
-  DT_LOG_TRACE(get_logging_priority(), "Entering...");
-  DT_THROW_IF(! is_initialized(), std::logic_error,
-              "Module '" << get_name() << "' is not initialized !");
+  // Containers of the previous event are gone, their memory is reused
+  shard_.arena.release();
+  event_arena::scope an_arena_scope(shard_.arena);
 
-   // std::cout << " ---------------------------------------------------------------------------------- " << std::endl;
+  // Outcome of the event, recorded whatever the stage it ends at
+  event_outcome_store::row_type an_outcome = {-1, -1, 0, 0, 0, event_.number_of_calibrated_hits, 0, 0};
+  if (event_.eh)
+    {
+      an_outcome.run_number = event_.eh->get_id().get_run_number();
+      an_outcome.event_number = event_.eh->get_id().get_event_number();
+    }
+  shard_.run_number = an_outcome.run_number;
+  shard_.event_number = an_outcome.event_number;
+  if (! accepted_)
+    {
+      an_outcome.flags |= event_outcome_store::PREFILTERED;
+      _record_outcome(an_outcome, shard_);
+      return dpp::base_module::PROCESS_STOP;
+    }
+  for (const auto ienergy : event_.hit_energies) an_outcome.total_gamma_energy += ienergy;
 
-  gamma_dict_type clustered_gammas;
+  _store_hit_table(event_, shard_);
+
+  std::vector<gamma_dict_type, arena_allocator<gamma_dict_type> > clustered_gammas(_clustering_gaps_.size());
   {
-    _pre_process_clustering(data_record_, clustered_gammas);
+    stage_timing::scope a_timer(shard_.timing, stage_timing::CLUSTERING);
+    _pre_process_clustering(event_, clustered_gammas.data(), shard_);
   }
+  an_outcome.number_of_clustered_gammas = clustered_gammas[0].size();
 
   gamma_dict_type simulated_gammas;
   {
-    const process_status status = _process_simulated_gammas(data_record_, simulated_gammas);
+    stage_timing::scope a_timer(shard_.timing, stage_timing::SIMULATED);
+    const process_status status = _process_simulated_gammas(event_, simulated_gammas, shard_);
+    an_outcome.number_of_simulated_gammas = simulated_gammas.size();
     if (status != dpp::base_module::PROCESS_OK) {
       DT_LOG_ERROR(get_logging_priority(), "Processing of simulated data fails !");
+      _record_outcome(an_outcome, shard_);
       return status;
     }
   }
 
   gamma_dict_type reconstructed_gammas;
   {
-    const process_status status = _process_reconstructed_gammas(data_record_, reconstructed_gammas);
+    stage_timing::scope a_timer(shard_.timing, stage_timing::RECONSTRUCTED);
+    const process_status status = _process_reconstructed_gammas(event_, reconstructed_gammas, shard_);
+    an_outcome.number_of_reconstructed_gammas = reconstructed_gammas.size();
     if (status != dpp::base_module::PROCESS_OK) {
       DT_LOG_ERROR(get_logging_priority(), "Processing of particle track data fails !");
+      _record_outcome(an_outcome, shard_);
       return status;
     }
     // return dpp::base_module::PROCESS_OK;
   }
 
-  _compare_sequences(simulated_gammas, reconstructed_gammas);
+  {
+    stage_timing::scope a_timer(shard_.timing, stage_timing::COMPARISON);
+    an_outcome.flags |= event_outcome_store::COMPARED;
+    if (_compare_sequences(simulated_gammas, reconstructed_gammas, shard_))
+      an_outcome.flags |= event_outcome_store::GT_MATCHED;
+
+    if (_compare_sequences_cluster(simulated_gammas, clustered_gammas[0], shard_))
+      an_outcome.flags |= event_outcome_store::NO_GT_MATCHED;
 
-  _compare_sequences_cluster(simulated_gammas, clustered_gammas);
+    if (! _time_gap_scan_.empty()) _compare_sequences_scan(simulated_gammas, clustered_gammas.data() + 1, shard_);
 
-  // const process_status status = _compute_gamma_track_length(data_record_);
-  // if (status != dpp::base_module::PROCESS_OK) {
-  //   DT_LOG_ERROR(get_logging_priority(), "Computing the gamma track length fails !");
-  //   return status;
-  // }
+    _fill_binned_efficiencies(an_outcome, shard_);
+  }
+  _record_outcome(an_outcome, shard_);
+
+  if (_track_length_)
+    {
+      stage_timing::scope a_timer(shard_.timing, stage_timing::TRACK_LENGTH);
+      const process_status status = _compute_gamma_track_length(event_, shard_);
+      if (status != dpp::base_module::PROCESS_OK) {
+        DT_LOG_ERROR(get_logging_priority(), "Computing the gamma track length fails !");
+        return status;
+      }
+    }
 
-  DT_LOG_TRACE(get_logging_priority(), "Exiting.");
     return dpp::base_module::PROCESS_SUCCESS;
 
 }
 
-dpp::base_module::process_status snemo_gamma_tracking_efficiency_module::_process_simulated_gammas(const datatools::things & data_record_,
-                                                                                                   gamma_dict_type & simulated_gammas_)
+dpp::base_module::process_status snemo_gamma_tracking_efficiency_module::_process_simulated_gammas(const gamma_event_view & event_,
+                                                                                                   gamma_dict_type & simulated_gammas_,
+                                                                                                   shard_type & shard_)
 {
   // Check if some 'simulated_data' are available in the data model:
-  const std::string sd_label = snemo::datamodel::data_info::default_simulated_data_label();
-  if (! data_record_.has(sd_label)) {
+  if (! event_.sd) {
     DT_LOG_ERROR(get_logging_priority(), "Missing simulated data to be processed !");
     return dpp::base_module::PROCESS_ERROR;
   }
-  // Get the 'simulated_data' entry from the data model :
-  const mctools::simulated_data & sd = data_record_.get<mctools::simulated_data>(sd_label);
 
   DT_LOG_DEBUG(get_logging_priority(), "Simulated data : ");
-  if (get_logging_priority() >= datatools::logger::PRIO_DEBUG) sd.tree_dump();
+  if (get_logging_priority() >= datatools::logger::PRIO_DEBUG) event_.sd->tree_dump();
 
   // Get total number of gammas simulated
-  _efficiency_.ngamma = 0;
-  for (auto i : sd.get_primary_event().get_particles()) {
-    if (i.is_gamma()) _efficiency_.ngamma++;
-  }
+  shard_.efficiency.ngamma = event_.number_of_primary_gammas;
 
   // Check if some 'calibrated_data' are available in the data model:
-  const std::string cd_label = snemo::datamodel::data_info::default_calibrated_data_label();
-  if (! data_record_.has(cd_label)) {
+  if (! event_.cd) {
     DT_LOG_ERROR(get_logging_priority(), "Missing calibrated data to be processed !");
     return dpp::base_module::PROCESS_ERROR;
   }
 
-  // Get the 'calibrated_data' entry from the data model :
-  const snemo::datamodel::calibrated_data & cd
-    = data_record_.get<snemo::datamodel::calibrated_data>(cd_label);
-
   DT_LOG_DEBUG(get_logging_priority(), "Calibrated data : ");
-  if (get_logging_priority() >= datatools::logger::PRIO_DEBUG) cd.tree_dump();
-
-  // Stop proccess if no calibrated calorimeters
-  if (! cd.has_calibrated_calorimeter_hits())
+  if (get_logging_priority() >= datatools::logger::PRIO_DEBUG) event_.cd->tree_dump();
+
+  // Simulated step hits from calorimeter blocks
+  if (! event_.has_step_hits) return dpp::base_module::PROCESS_STOP;
+
+  dpp::base_module::process_status status = dpp::base_module::PROCESS_OK;
+  size_t nattributed = 0;
+  switch (shard_.sequences.build_simulated(event_.calibrated_channels.data(), event_.calibrated_channels.size(),
+                                           event_.step_channels.data(), event_.step_track_ids.data(),
+                                           event_.step_channels.size(), shard_.efficiency.ngamma,
+                                           simulated_gammas_, nattributed)) {
+  case gamma_sequence_builder::NO_CALIBRATED_HITS:
+    // Stop proccess if no calibrated calorimeters
     return dpp::base_module::PROCESS_STOP;
-
-  const snemo::datamodel::calibrated_data::calorimeter_hit_collection_type & cch
-    = cd.calibrated_calorimeter_hits();
-
-  // Fetch simulated step hits from calorimeter blocks
-  const std::string hit_label = "__visu.tracks.calo";
-  if (! sd.has_step_hits(hit_label)) return dpp::base_module::PROCESS_STOP;
-  const mctools::simulated_data::hit_handle_collection_type & hit_collection
-    = sd.get_step_hits(hit_label);
-  if (hit_collection.empty()) {
+  case gamma_sequence_builder::NO_STEP_HITS:
     DT_LOG_DEBUG(get_logging_priority(), "No simulated calorimeter hits");
     return dpp::base_module::PROCESS_STOP;
-  }
-
-  std::set<geomtools::geom_id> already_gids;
-
-  for (auto ihit : hit_collection) {
-    const mctools::base_step_hit & a_hit = ihit.get();
-    const datatools::properties & a_aux = a_hit.get_auxiliaries();
-
-    int track_id = -1;
-    if (a_aux.has_key(mctools::track_utils::TRACK_ID_KEY)) {
-      track_id = a_aux.fetch_integer(mctools::track_utils::TRACK_ID_KEY);
-    }
-    if (a_aux.has_key(mctools::track_utils::PARENT_TRACK_ID_KEY)) {
-      track_id = a_aux.fetch_integer(mctools::track_utils::PARENT_TRACK_ID_KEY);
+  case gamma_sequence_builder::SECONDARY_PARTICLE:
+    {
+      const uint64_t a_rank = _mismatches_.count(mismatch_report::SECONDARY_PARTICLE);
+      if (_mismatches_.is_sampled(a_rank))
+        DT_LOG_WARNING(get_logging_priority(), "Mismatch 'secondary_particle' #" << a_rank << " (run " << shard_.run_number
+                       << ", event " << shard_.event_number << ") : secondary particle triggering new calo, "
+                       << shard_.efficiency.ngamma << " primary gammas");
     }
-    DT_THROW_IF(track_id == -1, std::logic_error, "Missing primary track id !");
-    if (track_id == 0) continue; // From a primary particles
-
-    // Check if calorimeter has been calibrated
-    const geomtools::geom_id & gid = a_hit.get_geom_id();
-    if (
-        std::find_if(cch.begin(), cch.end(), [gid] (auto hit_)
-                     {
-                       return gid == hit_.get().get_geom_id();
-                     }
-                     ) == cch.end()
-        ) continue;
-
-
-    // if(simulated_gammas_[track_id].size() != 0 )
-    //   {
-    //     // DT_LOG_WARNING(get_logging_priority(), std::endl << "track id already added !" << std::endl);
-    //     continue;
-    //   }
-
-    // Gid already attributed to a gamma
-    if (already_gids.count(gid) != 0)
-      {
-        // DT_LOG_WARNING(get_logging_priority(), std::endl << "GID already found !" << already_gids.count(gid) << std::endl);
-        continue;
-      }
-
-    if (track_id > (int)_efficiency_.ngamma + 1) //continue; // Not from a primary particles // Hack : removes around 10% of the stat
-      {
-        DT_LOG_WARNING(get_logging_priority(), "Secondary particle triggering new calo "<< _efficiency_.ngamma);
-        return dpp::base_module::PROCESS_STOP;
-      }
-
-    already_gids.insert(gid);
-
-    // DT_LOG_WARNING(get_logging_priority(), std::endl << "Inserting gid " << already_gids.count(gid));
-
-    simulated_gammas_[track_id].insert(gid);
-
-    // Build unique key for histogram map:
-    std::ostringstream key;
-    key << "total_number_of_calos";
-
-    // Getting histogram pool
-    mygsl::histogram_pool & a_pool = grab_histogram_pool();
-
-    if (! a_pool.has(key.str()))
-      {
-        mygsl::histogram_1d & h = a_pool.add_1d(key.str(), "", "number_of_calos");
-        datatools::properties hconfig;
-        hconfig.store_string("mode", "mimic");
-        hconfig.store_string("mimic.histogram_1d", "number_of_calos_template");
-        mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-      }
-
-    // Getting the current histogram
-    mygsl::histogram_1d & a_histo = a_pool.grab_1d(key.str ());
-    a_histo.fill(cch.size());
-
-    // std::cout << " simulated cch size " << cch.size() <<std::endl;
-
-
+    status = dpp::base_module::PROCESS_STOP;
+    break;
+  default:
+    break;
   }
 
-  return dpp::base_module::PROCESS_OK;
+  // Total number of calorimeters is filled once per attributed calorimeter
+  mygsl::histogram_1d & a_histo = shard_.histograms.get(histogram_registry::TOTAL_NUMBER_OF_CALOS);
+  for (size_t i = 0; i < nattributed; i++) a_histo.fill(event_.calibrated_channels.size());
+
+  return status;
 }
 
-dpp::base_module::process_status snemo_gamma_tracking_efficiency_module::_compute_gamma_track_length(const datatools::things & data_record_)
+dpp::base_module::process_status snemo_gamma_tracking_efficiency_module::_compute_gamma_track_length(const gamma_event_view & event_,
+                                                                                                     shard_type & shard_)
 {
-
-  // Check if some 'simulated_data' are available in the data model:
-  const std::string sd_label = snemo::datamodel::data_info::default_simulated_data_label();
-  if (! data_record_.has(sd_label)) {
-    DT_LOG_ERROR(get_logging_priority(), "Missing simulated data to be processed !");
-    return dpp::base_module::PROCESS_ERROR;
-  }
-  // Get the 'simulated_data' entry from the data model :
-  const mctools::simulated_data & sd = data_record_.get<mctools::simulated_data>(sd_label);
-
-  double simu_gamma_track_length = 0.;
-  for (auto i : sd.get_primary_event().get_particles()) {
-
-    if (!i.is_gamma()) continue;
-
-    for(unsigned int i = 0; i<1; i++) //if more than one label
-      {
-        // Fetch simulated step hits from calorimeter blocks
-        // const std::string hit_label = "__visu.tracks";
-        const std::string hit_label = "__visu.tracks.calo";
-        if (! sd.has_step_hits(hit_label)) return dpp::base_module::PROCESS_STOP;
-        const mctools::simulated_data::hit_handle_collection_type & hit_collection
-          = sd.get_step_hits(hit_label);
-        if (hit_collection.empty())
-          {
-            DT_LOG_DEBUG(get_logging_priority(), "No simulated calorimeter hits");
-            return dpp::base_module::PROCESS_STOP;
-          }
-
-        for (auto ihit : hit_collection)
-          {
-            const mctools::base_step_hit & a_hit = ihit.get();
-            const datatools::properties & a_aux = a_hit.get_auxiliaries();
-
-            const geomtools::vector_3d & a_hit_start = a_hit.get_position_start();
-            const geomtools::vector_3d & a_hit_stop = a_hit.get_position_stop();
-
-            simu_gamma_track_length += (a_hit_stop-a_hit_start).mag();
-          }
-      }
-    std::cout<< "------- Simulated gamma track length : " << simu_gamma_track_length << std::endl;
-  }
-
-  // Check if some 'particle_track_data' are available in the data model:
-  const std::string ptd_label = snemo::datamodel::data_info::default_particle_track_data_label();
-  if (! data_record_.has(ptd_label)) {
-    DT_LOG_ERROR(get_logging_priority(), "Missing particle track data to be processed !");
-    return dpp::base_module::PROCESS_ERROR;
+  // Path length of the simulated primary gammas secondaries within the
+  // calorimeter blocks, from the step hits of all the gammas at once
+  if (event_.step_hits.empty() || event_.gamma_tracks.empty()) return dpp::base_module::PROCESS_STOP;
+  path_length & the_steps = shard_.simulated_path;
+  the_steps.clear();
+  for (const auto ihit : event_.step_hits) {
+    const geomtools::vector_3d & a_start = ihit->get_position_start();
+    const geomtools::vector_3d & a_stop = ihit->get_position_stop();
+    the_steps.add(a_start.x(), a_start.y(), a_start.z(), a_stop.x(), a_stop.y(), a_stop.z());
   }
-
-  // Get the 'particle_track_data' entry from the data model :
-  const snemo::datamodel::particle_track_data & ptd
-    = data_record_.get<snemo::datamodel::particle_track_data>(ptd_label);
-
-  DT_LOG_DEBUG(get_logging_priority(), "Particle track data : ");
-  if (get_logging_priority() >= datatools::logger::PRIO_DEBUG) ptd.tree_dump();
-
-  snemo::datamodel::particle_track_data::particle_collection_type gammas;
-  const size_t ngammas = ptd.fetch_particles(gammas, snemo::datamodel::particle_track::NEUTRAL);
-
-  if (ngammas == 0) return dpp::base_module::PROCESS_STOP;
-
-  double reco_gamma_track_length = 0;
-
-  for (auto igamma : gammas) {
-
-
-    const snemo::datamodel::particle_track::vertex_collection_type the_vertices = igamma.get().get_vertices();
-
-    unsigned int count_vtx = 0;
-
-    for (auto ivtx : the_vertices)
-      {
-        // count_vtx++;
-
-        // if (count_vtx == the_vertices.size()-1)
-        //   break;
-
-        const geomtools::blur_spot & a_spot = ivtx.get();
-        const geomtools::blur_spot & next_spot = std::next(&ivtx)->get();
-
-        reco_gamma_track_length += (next_spot.get_position() - a_spot.get_position()).mag();
-
-      }
-
-    std::cout<< "------- Reconstructed gamma track length : " << reco_gamma_track_length << std::endl;
-
-
-    // Check if some 'calibrated_data' are available in the data model:
-    const std::string cd_label = snemo::datamodel::data_info::default_calibrated_data_label();
-    if (! data_record_.has(cd_label)) {
-      DT_LOG_ERROR(get_logging_priority(), "Missing calibrated data to be processed !");
-      return dpp::base_module::PROCESS_ERROR;
+  const double simu_gamma_track_length = the_steps.get_length();
+
+  // Path length of the reconstructed gammas, from vertex to vertex
+  path_length & the_segments = shard_.reconstructed_path;
+  the_segments.clear();
+  for (const auto igamma : event_.gamma_tracks) {
+    const snemo::datamodel::particle_track::vertex_collection_type & the_vertices = igamma->get_vertices();
+    for (size_t ivtx = 1; ivtx < the_vertices.size(); ivtx++) {
+      const geomtools::vector_3d & a_start = the_vertices[ivtx - 1].get().get_position();
+      const geomtools::vector_3d & a_stop = the_vertices[ivtx].get().get_position();
+      the_segments.add(a_start.x(), a_start.y(), a_start.z(), a_stop.x(), a_stop.y(), a_stop.z());
     }
-    // Get the 'calibrated_data' entry from the data model :
-    const snemo::datamodel::calibrated_data & cd
-      = data_record_.get<snemo::datamodel::calibrated_data>(cd_label);
-
-    // Stop proccess if no calibrated calorimeters
-    if (! cd.has_calibrated_calorimeter_hits()) return dpp::base_module::PROCESS_STOP;
-
-    const snemo::datamodel::calibrated_data::calorimeter_hit_collection_type & cch
-      = cd.calibrated_calorimeter_hits();
-
-    // Build unique key for histogram map:
-    std::ostringstream key;
-    key << cch.size();
-    key <<"calos_";
-    key << "delta_L";
-
-    if(reco_gamma_track_length < 400)
-      key << "_cluster";
-    else
-      key << "not_cluster";
-
-    if(cch.size()==2 && (simu_gamma_track_length - reco_gamma_track_length ) < -800.)
-      std::cout << std::endl << "Check it out " << std::endl << std::endl;
-
-    // Getting histogram pool
-    mygsl::histogram_pool & a_pool = grab_histogram_pool();
-
-    if (! a_pool.has(key.str()))
-      {
-        mygsl::histogram_1d & h = a_pool.add_1d(key.str(), "", "delta_L");
-        datatools::properties hconfig;
-        hconfig.store_string("mode", "mimic");
-        hconfig.store_string("mimic.histogram_1d", "delta_L_template");
-        mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-      }
+  }
+  const double reco_gamma_track_length = the_segments.get_length();
 
-    // Getting the current histogram
-    mygsl::histogram_1d & a_histo = a_pool.grab_1d(key.str ());
-    a_histo.fill((simu_gamma_track_length - reco_gamma_track_length )*CLHEP::keV);
+  DT_LOG_DEBUG(get_logging_priority(), "Gamma track length : simulated = " << simu_gamma_track_length / CLHEP::mm
+               << " mm, reconstructed = " << reco_gamma_track_length / CLHEP::mm << " mm");
 
-  }
+  // Histograms are named after the number of calibrated calorimeters and
+  // split between short (clustered calorimeters) and long gamma paths
+  const histogram_registry::family_id a_family = reco_gamma_track_length < 400 * CLHEP::mm
+    ? histogram_registry::DELTA_L_CLUSTER : histogram_registry::DELTA_L_NOT_CLUSTER;
+  shard_.histograms.get(a_family, event_.calibrated_channels.size())
+    .fill((simu_gamma_track_length - reco_gamma_track_length) / CLHEP::m);
 
   return dpp::base_module::PROCESS_OK;
 }
 
-dpp::base_module::process_status snemo_gamma_tracking_efficiency_module::_process_reconstructed_gammas(const datatools::things & data_record_,
-                                                                                                       gamma_dict_type & reconstructed_gammas_)
+dpp::base_module::process_status snemo_gamma_tracking_efficiency_module::_process_reconstructed_gammas(const gamma_event_view & event_,
+                                                                                                       gamma_dict_type & reconstructed_gammas_,
+                                                                                                       shard_type & shard_)
 {
   // Check if some 'particle_track_data' are available in the data model:
-  const std::string ptd_label = snemo::datamodel::data_info::default_particle_track_data_label();
-  if (! data_record_.has(ptd_label)) {
+  if (! event_.ptd) {
     DT_LOG_ERROR(get_logging_priority(), "Missing particle track data to be processed !");
     return dpp::base_module::PROCESS_ERROR;
   }
 
-  // Get the 'particle_track_data' entry from the data model :
-  const snemo::datamodel::particle_track_data & ptd
-    = data_record_.get<snemo::datamodel::particle_track_data>(ptd_label);
-
   DT_LOG_DEBUG(get_logging_priority(), "Particle track data : ");
-  if (get_logging_priority() >= datatools::logger::PRIO_DEBUG) ptd.tree_dump();
+  if (get_logging_priority() >= datatools::logger::PRIO_DEBUG) event_.ptd->tree_dump();
 
-  snemo::datamodel::particle_track_data::particle_collection_type gammas;
-  const size_t ngammas = ptd.fetch_particles(gammas, snemo::datamodel::particle_track::NEUTRAL);
+  const size_t ngammas = event_.get_number_of_gammas();
   if (ngammas == 0) return dpp::base_module::PROCESS_STOP;
 
   DT_LOG_DEBUG(get_logging_priority(), std::endl << "Number of gammas : " << ngammas << std::endl);
 
-  for (auto igamma : gammas) {
-    for (auto icalo : igamma.get().get_associated_calorimeter_hits()) {
-      const geomtools::geom_id & gid = icalo.get().get_geom_id();
-      reconstructed_gammas_[igamma.get().get_track_id()].insert(gid);
-    }
-  }
-
-  // Build unique key for histogram map:
-  std::ostringstream key;
-  key << "number_of_gammas";
-
-  // Getting histogram pool
-  mygsl::histogram_pool & a_pool = grab_histogram_pool();
-
-  if (! a_pool.has(key.str()))
-    {
-      mygsl::histogram_1d & h = a_pool.add_1d(key.str(), "", "number_of_calos");
-      datatools::properties hconfig;
-      hconfig.store_string("mode", "mimic");
-      hconfig.store_string("mimic.histogram_1d", "number_of_calos_template");
-      mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-    }
-
-  // Getting the current histogram
-  mygsl::histogram_1d & a_histo = a_pool.grab_1d(key.str ());
-  a_histo.fill(ngammas);
+  const size_t nunknown = shard_.sequences.build_reconstructed(event_.hit_channels.data(), event_.hit_gammas.data(),
+                                                              event_.gamma_track_ids.data(), event_.get_number_of_hits(),
+                                                              reconstructed_gammas_);
+  if (nunknown > 0) _report_unknown_channels(nunknown);
 
-  key.str("");
-  key.clear();
-
-  key << "total_gamma_energy";
+  shard_.histograms.get(histogram_registry::NUMBER_OF_GAMMAS).fill(ngammas);
 
   double total_gamma_energy = 0;
   double E_1 = 0;
@@ -862,28 +1510,26 @@ dpp::base_module::process_status snemo_gamma_tracking_efficiency_module::_proces
   double ncalos_mid = 0;
   double ncalos_max = 0;
 
-  int count_gamma = 0;
-  for (auto igamma : gammas) {
-    count_gamma++;
-    // std::cout << "igamma : " << igamma << std::endl;
-    for (auto icalo : igamma.get().get_associated_calorimeter_hits()) {
-      total_gamma_energy += icalo.get().get_energy();
-      if(count_gamma==1)
-        {
-          E_1 += icalo.get().get_energy();
-          ncalos_1 = igamma.get().get_associated_calorimeter_hits().size();
-        }
-      if(count_gamma==2)
-        {
-          E_2 += icalo.get().get_energy();
-          ncalos_2 = igamma.get().get_associated_calorimeter_hits().size();
-        }
-      if(count_gamma==3)
-        {
-          E_3 += icalo.get().get_energy();
-          ncalos_3 = igamma.get().get_associated_calorimeter_hits().size();
-        }
-    }
+  for (size_t ihit = 0; ihit < event_.get_number_of_hits(); ihit++) {
+    const double an_energy = event_.hit_energies[ihit];
+    const uint32_t a_gamma = event_.hit_gammas[ihit];
+    const size_t ncalos = event_.gamma_offsets[a_gamma + 1] - event_.gamma_offsets[a_gamma];
+    total_gamma_energy += an_energy;
+    if(a_gamma==0)
+      {
+        E_1 += an_energy;
+        ncalos_1 = ncalos;
+      }
+    if(a_gamma==1)
+      {
+        E_2 += an_energy;
+        ncalos_2 = ncalos;
+      }
+    if(a_gamma==2)
+      {
+        E_3 += an_energy;
+        ncalos_3 = ncalos;
+      }
   }
 
   // std::cout << "E1 : " << E_1 << std::endl;
@@ -897,132 +1543,58 @@ dpp::base_module::process_status snemo_gamma_tracking_efficiency_module::_proces
       E_max = std::max(std::max(E_1,E_2),E_3);
     }
 
-  if (! a_pool.has(key.str()))
-    {
-      mygsl::histogram_1d & h = a_pool.add_1d(key.str(), "", "total_gamma_energy");
-      datatools::properties hconfig;
-      hconfig.store_string("mode", "mimic");
-      hconfig.store_string("mimic.histogram_1d", "energy_template");
-      mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-    }
+  shard_.histograms.get(histogram_registry::TOTAL_GAMMA_ENERGY).fill(total_gamma_energy);
 
-  // Getting the current histogram
-  mygsl::histogram_1d & a_histo_total_gamma_energy = a_pool.grab_1d(key.str ());
-  a_histo_total_gamma_energy.fill(total_gamma_energy);
+  // Histograms are named after the number of calorimeters of the lowest
+  // energy gamma (several numbers are concatenated in case of equality)
+  unsigned int ncalos_key = 0;
+  if(E_min == E_1)
+    ncalos_key = concatenate_key(ncalos_key, ncalos_1);
+  if(E_min == E_2)
+    ncalos_key = concatenate_key(ncalos_key, ncalos_2);
+  if(E_min == E_3)
+    ncalos_key = concatenate_key(ncalos_key, ncalos_3);
 
   if(E_min != 0)
-    {
-      key.str("");
-      key.clear();
-
-      if(E_min == E_1)
-        key << ncalos_1;
-      if(E_min == E_2)
-        key << ncalos_2;
-      if(E_min == E_3)
-        key << ncalos_3;
-
-      key << "_gamma_energy_min";
-
-      if (! a_pool.has(key.str()))
-        {
-          mygsl::histogram_1d & h = a_pool.add_1d(key.str(), "", "gamma_energy_min");
-          datatools::properties hconfig;
-          hconfig.store_string("mode", "mimic");
-          hconfig.store_string("mimic.histogram_1d", "energy_template");
-          mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-        }
-
-      // Getting the current histogram
-      mygsl::histogram_1d & a_histo_gamma_energy_min = a_pool.grab_1d(key.str ());
-      a_histo_gamma_energy_min.fill(E_min);
-    }
+    shard_.histograms.get(histogram_registry::GAMMA_ENERGY_MIN, ncalos_key).fill(E_min);
 
   if(E_mid != 0)
-    {
-      key.str("");
-      key.clear();
-
-      if(E_min == E_1)
-        key << ncalos_1;
-      if(E_min == E_2)
-        key << ncalos_2;
-      if(E_min == E_3)
-        key << ncalos_3;
-
-      key << "_gamma_energy_mid";
-
-      if (! a_pool.has(key.str()))
-        {
-          mygsl::histogram_1d & h = a_pool.add_1d(key.str(), "", "gamma_energy_mid");
-          datatools::properties hconfig;
-          hconfig.store_string("mode", "mimic");
-          hconfig.store_string("mimic.histogram_1d", "energy_template");
-          mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-        }
-
-      // Getting the current histogram
-      mygsl::histogram_1d & a_histo_gamma_energy_mid = a_pool.grab_1d(key.str ());
-      a_histo_gamma_energy_mid.fill(E_mid);
-    }
+    shard_.histograms.get(histogram_registry::GAMMA_ENERGY_MID, ncalos_key).fill(E_mid);
 
   if(E_max != 0)
-    {
-      key.str("");
-      key.clear();
-
-      if(E_min == E_1)
-        key << ncalos_1;
-      if(E_min == E_2)
-        key << ncalos_2;
-      if(E_min == E_3)
-        key << ncalos_3;
-
-      key << "_gamma_energy_max";
-
-      if (! a_pool.has(key.str()))
-        {
-          mygsl::histogram_1d & h = a_pool.add_1d(key.str(), "", "gamma_energy_max");
-          datatools::properties hconfig;
-          hconfig.store_string("mode", "mimic");
-          hconfig.store_string("mimic.histogram_1d", "energy_template");
-          mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-        }
-
-      // Getting the current histogram
-      mygsl::histogram_1d & a_histo_gamma_energy_max = a_pool.grab_1d(key.str ());
-      a_histo_gamma_energy_max.fill(E_max);
-    }
+    shard_.histograms.get(histogram_registry::GAMMA_ENERGY_MAX, ncalos_key).fill(E_max);
 
   return dpp::base_module::PROCESS_OK;
 }
 
 bool snemo_gamma_tracking_efficiency_module::_compare_sequences(const gamma_dict_type & simulated_gammas_,
-                                                                const gamma_dict_type & reconstructed_gammas_)
+                                                                const gamma_dict_type & reconstructed_gammas_,
+                                                                shard_type & shard_)
 {
-  _efficiency_.nevent++;
+  gamma_sequence_matcher::match_type a_match;
+  shard_.matcher.match(simulated_gammas_, reconstructed_gammas_, a_match);
+  _account_for_kinds(a_match, false, shard_);
+  const size_t tmp_ngood_gammas = a_match.nidentical;
+  const bool good_event = shard_.efficiency.add_comparison(simulated_gammas_.size(), reconstructed_gammas_.size(),
+                                                           tmp_ngood_gammas);
 
   if (reconstructed_gammas_.empty() && simulated_gammas_.empty())
     {
       DT_LOG_DEBUG(get_logging_priority(), "No gammas have been catched and reconstructed !");
-      _efficiency_.nmiss++;
-      return false;
+      return good_event;
     }
 
-  _efficiency_.ntotal += simulated_gammas_.size();
-
 //  std::cout << "simulated gamma size " <<simulated_gammas_.size() << std::endl;
 
-  if(simulated_gammas_.size()>0)
-    {
-      _efficiency_.nevent_gammas++;
-    }
-
   if (simulated_gammas_.size() > 1) {
     //*    DT_LOG_WARNING(datatools::logger::PRIO_WARNING, "More than one gammas simulated");
   }
   if (simulated_gammas_.size() == 0) {
-    DT_LOG_WARNING(datatools::logger::PRIO_WARNING, "No gammas simulated");
+    const uint64_t a_rank = _mismatches_.count(mismatch_report::GT_NO_SIMULATED_GAMMA);
+    if (_mismatches_.is_sampled(a_rank))
+      DT_LOG_WARNING(get_logging_priority(), "Mismatch 'gt_no_simulated_gamma' #" << a_rank << " (run " << shard_.run_number
+                     << ", event " << shard_.event_number << ") : " << reconstructed_gammas_.size()
+                     << " reconstructed gammas, no gammas simulated");
   }
 
   if (get_logging_priority() >= datatools::logger::PRIO_DEBUG) {
@@ -1031,7 +1603,7 @@ bool snemo_gamma_tracking_efficiency_module::_compare_sequences(const gamma_dict
       std::ostringstream oss;
       oss << "Gamma #" << i.first << " :";
       for (auto icalo : i.second) {
-        oss << " -> " << icalo;
+        oss << " -> " << _channels_.get_geom_id(icalo);
       }
       DT_LOG_DEBUG(get_logging_priority(), oss.str());
     }
@@ -1040,57 +1612,47 @@ bool snemo_gamma_tracking_efficiency_module::_compare_sequences(const gamma_dict
       std::ostringstream oss;
       oss << "Gamma #" << i.first << " :";
       for (auto icalo : i.second) {
-        oss << " -> " << icalo;
+        oss << " -> " << _channels_.get_geom_id(icalo);
       }
       DT_LOG_DEBUG(get_logging_priority(), oss.str());
     }
   }
 
-  size_t tmp_ngood_gammas = 0 ;
-  for (auto irec : reconstructed_gammas_) {
-    const calo_list_type & a_rec_list = irec.second;
-    for (auto isim : simulated_gammas_) {
-      const calo_list_type & a_sim_list = isim.second;
-      if (a_rec_list.size() != a_sim_list.size()) continue;
-      const bool are_same = std::equal(a_rec_list.begin(), a_rec_list.end(), a_sim_list.begin());
-      if (are_same) {
-        _efficiency_.ngood++;
-        tmp_ngood_gammas++;
-        DT_LOG_DEBUG(get_logging_priority(), "Sequences are identical !");
-        break;
-      }
-      //* else
-        //* DT_LOG_WARNING(get_logging_priority(), "Sequences are different !");
-    }
-  }
+  DT_LOG_DEBUG(get_logging_priority(), "Number of identical sequences : " << tmp_ngood_gammas);
 
-  if(tmp_ngood_gammas == simulated_gammas_.size() && simulated_gammas_.size() > 0)
+  if(good_event)
     {
       DT_LOG_DEBUG(get_logging_priority(), std::endl << "°°°°°° Fully good event with at least one gamma ! °°°°°°" << std::endl);
-      _efficiency_.ngood_event++;
-      return true;
     }
   else
     {
       if(simulated_gammas_.size() > 0)
-        DT_LOG_WARNING(get_logging_priority(), std::endl<<" ||||||||||||||||" << std::endl << "tmp_ngood_gammas " << tmp_ngood_gammas << std::endl
-                       << "simulated_gammas_.size() " << simulated_gammas_.size() << std::endl
-                       << "reconstructed_gammas_.size() " << reconstructed_gammas_.size() << std::endl );
-      return false;
+        {
+          const uint64_t a_rank = _mismatches_.count(mismatch_report::GT_MISMATCH);
+          if (_mismatches_.is_sampled(a_rank))
+            DT_LOG_WARNING(get_logging_priority(), "Mismatch 'gt_mismatch' #" << a_rank << " (run " << shard_.run_number
+                           << ", event " << shard_.event_number << ") : " << tmp_ngood_gammas << " identical sequences, "
+                           << simulated_gammas_.size() << " simulated and " << reconstructed_gammas_.size() << " reconstructed gammas"
+                           << mismatch_kinds_summary(a_match));
+        }
     }
+  return good_event;
 }
 bool snemo_gamma_tracking_efficiency_module::_compare_sequences_cluster(const gamma_dict_type & simulated_gammas_,
-                                                                const gamma_dict_type & clustered_gammas_)
+                                                                        const gamma_dict_type & clustered_gammas_,
+                                                                        shard_type & shard_)
 {
+  gamma_sequence_matcher::match_type a_match;
+  shard_.matcher.match(simulated_gammas_, clustered_gammas_, a_match);
+  _account_for_kinds(a_match, true, shard_);
+  const size_t tmp_ngood_gammas = a_match.nidentical;
+  const bool good_event = shard_.no_gt_efficiency.add_cluster_comparison(simulated_gammas_.size(), clustered_gammas_.size(),
+                                                                         tmp_ngood_gammas);
+
   if (clustered_gammas_.empty() && simulated_gammas_.empty())
     {
       DT_LOG_DEBUG(get_logging_priority(), "No gammas have been catched and clustered !");
-      return false;
-    }
-
-  if(simulated_gammas_.size()>0)
-    {
-      _no_gt_efficiency_.no_gt_nevent_gammas++;
+      return good_event;
     }
 
   //* if (simulated_gammas_.size() > 1) {
@@ -1098,7 +1660,11 @@ bool snemo_gamma_tracking_efficiency_module::_compare_sequences_cluster(const ga
   // }
 
   if (simulated_gammas_.size() == 0) {
-    DT_LOG_WARNING(datatools::logger::PRIO_WARNING, "Cluster : No gammas simulated");
+    const uint64_t a_rank = _mismatches_.count(mismatch_report::NO_GT_NO_SIMULATED_GAMMA);
+    if (_mismatches_.is_sampled(a_rank))
+      DT_LOG_WARNING(get_logging_priority(), "Mismatch 'no_gt_no_simulated_gamma' #" << a_rank << " (run " << shard_.run_number
+                     << ", event " << shard_.event_number << ") : " << clustered_gammas_.size()
+                     << " clustered gammas, no gammas simulated");
   }
 
   if (get_logging_priority() >= datatools::logger::PRIO_DEBUG) {
@@ -1107,7 +1673,7 @@ bool snemo_gamma_tracking_efficiency_module::_compare_sequences_cluster(const ga
       std::ostringstream oss;
       oss << "Gamma #" << i.first << " :";
       for (auto icalo : i.second) {
-        oss << " -> " << icalo;
+        oss << " -> " << _channels_.get_geom_id(icalo);
       }
       DT_LOG_DEBUG(get_logging_priority(), oss.str());
     }
@@ -1116,43 +1682,73 @@ bool snemo_gamma_tracking_efficiency_module::_compare_sequences_cluster(const ga
       std::ostringstream oss;
       oss << "Gamma #" << i.first << " :";
       for (auto icalo : i.second) {
-        oss << " -> " << icalo;
+        oss << " -> " << _channels_.get_geom_id(icalo);
       }
       DT_LOG_DEBUG(get_logging_priority(), oss.str());
     }
   }
 
-  size_t tmp_ngood_gammas = 0;
-  for (auto irec : clustered_gammas_) {
-    const calo_list_type & a_rec_list = irec.second;
-    for (auto isim : simulated_gammas_) {
-      const calo_list_type & a_sim_list = isim.second;
-      if (a_rec_list.size() != a_sim_list.size()) continue;
-      const bool are_same = std::equal(a_rec_list.begin(), a_rec_list.end(), a_sim_list.begin());
-      if (are_same) {
-        tmp_ngood_gammas++;
-        DT_LOG_DEBUG(get_logging_priority(), "Sequences are identical !");
-        break;
-      }
-      // else
-      //   DT_LOG_WARNING(get_logging_priority(), "Sequences are different !");
-    }
-  }
+  DT_LOG_DEBUG(get_logging_priority(), "Number of identical sequences : " << tmp_ngood_gammas);
 
-  if(tmp_ngood_gammas == simulated_gammas_.size() && simulated_gammas_.size() > 0)
+  if(good_event)
     {
       DT_LOG_DEBUG(get_logging_priority(), std::endl << "°°°°°° Fully good event with at least one gamma ! °°°°°°" << std::endl);
-      _no_gt_efficiency_.no_gt_ngood_event++;
-      return true;
     }
   else
     {
       if(simulated_gammas_.size() > 0)
-        DT_LOG_WARNING(get_logging_priority(), std::endl<<" &&&&&&&&&&&&&&&&" << std::endl << "tmp_ngood_gammas " << tmp_ngood_gammas << std::endl
-                       << "simulated_gammas_.size() " << simulated_gammas_.size() << std::endl
-                       << "clustered_gammas_.size() " << clustered_gammas_.size() << std::endl );
-      return false;
+        {
+          const uint64_t a_rank = _mismatches_.count(mismatch_report::NO_GT_MISMATCH);
+          if (_mismatches_.is_sampled(a_rank))
+            DT_LOG_WARNING(get_logging_priority(), "Mismatch 'no_gt_mismatch' #" << a_rank << " (run " << shard_.run_number
+                           << ", event " << shard_.event_number << ") : " << tmp_ngood_gammas << " identical sequences, "
+                           << simulated_gammas_.size() << " simulated and " << clustered_gammas_.size() << " clustered gammas"
+                           << mismatch_kinds_summary(a_match));
+        }
     }
+  return good_event;
+}
+
+void snemo_gamma_tracking_efficiency_module::_account_for_kinds(const gamma_sequence_matcher::match_type & match_,
+                                                               bool clustered_,
+                                                               shard_type & shard_)
+{
+  _mismatches_.add_kinds(clustered_, match_);
+  mygsl::histogram_1d * a_histo = shard_.mismatch_kinds[clustered_];
+  if (! a_histo) return;
+  for (size_t i = 0; i < gamma_sequence_matcher::NUMBER_OF_MISMATCH_KINDS; i++) {
+    for (size_t j = 0; j < match_.kinds[i]; j++) a_histo->fill(i + 0.5);
+  }
+  return;
+}
+
+void snemo_gamma_tracking_efficiency_module::_fill_binned_efficiencies(const event_outcome_store::row_type & outcome_,
+                                                                      shard_type & shard_)
+{
+  // Same population as the events with gammas successfully reconstructed ratio
+  if (outcome_.number_of_simulated_gammas == 0) return;
+  const double the_values[NUMBER_OF_BINNINGS] = {(double) outcome_.number_of_simulated_gammas,
+                                                 outcome_.total_gamma_energy,
+                                                 (double) outcome_.number_of_calos};
+  const bool matched = outcome_.flags & event_outcome_store::GT_MATCHED;
+  const bool no_gt_matched = outcome_.flags & event_outcome_store::NO_GT_MATCHED;
+  for (size_t i = 0; i < NUMBER_OF_BINNINGS; i++) {
+    shard_.binned[i].fill(the_values[i], matched);
+    shard_.no_gt_binned[i].fill(the_values[i], no_gt_matched);
+  }
+  return;
+}
+
+void snemo_gamma_tracking_efficiency_module::_compare_sequences_scan(const gamma_dict_type & simulated_gammas_,
+                                                                    const gamma_dict_type * clustered_gammas_,
+                                                                    shard_type & shard_)
+{
+  for (size_t igap = 0; igap < _time_gap_scan_.size(); igap++) {
+    const size_t ngood_gammas = shard_.matcher.count_identical(simulated_gammas_, clustered_gammas_[igap]);
+    shard_.time_gap_scan[igap].add_cluster_comparison(simulated_gammas_.size(), clustered_gammas_[igap].size(),
+                                                      ngood_gammas);
+  }
+  return;
 }
 
 } // namespace analysis
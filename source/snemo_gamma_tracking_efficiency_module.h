@@ -36,6 +36,14 @@
 // Standard libraires:
 #include <set>
 #include <map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 // Third party:
 // - Bayeux/geomtools:
 #include <geomtools/geom_id.h>
@@ -45,9 +53,27 @@
 
 #include <snemo/datamodels/calibrated_data.h>
 
-namespace mygsl {
-  class histogram_pool;
-}
+// - Bayeux/mygsl
+#include <mygsl/histogram_pool.h>
+
+// This project:
+#include <calorimeter_channel_index.h>
+#include <calorimeter_adjacency.h>
+#include <calorimeter_clustering.h>
+#include <gamma_event_view.h>
+#include <gamma_sequence_matcher.h>
+#include <gamma_sequence_builder.h>
+#include <gamma_efficiency.h>
+#include <binned_efficiency.h>
+#include <mismatch_report.h>
+#include <event_prefilter.h>
+#include <path_length.h>
+#include <stage_timing.h>
+#include <run_state.h>
+#include <event_outcome_store.h>
+#include <hit_table.h>
+#include <geometry_cache.h>
+#include <histogram_registry.h>
 
 namespace snemo {
   namespace geometry {
@@ -67,11 +93,25 @@ namespace analysis {
     /// Grabbing histogram pool
     mygsl::histogram_pool & grab_histogram_pool();
 
+    /// Typedef for calorimeter channel
+    typedef calorimeter_channel_index::channel_type channel_type;
+
     /// Typedef for calorimeters collection
-    typedef std::set<geomtools::geom_id> calo_list_type;
+    typedef gamma_sequence_matcher::calo_list_type calo_list_type;
 
     /// Typedef for gamma dictionnaries
-    typedef std::map<int, calo_list_type> gamma_dict_type;
+    typedef gamma_sequence_matcher::gamma_dict_type gamma_dict_type;
+
+    /// Variables the efficiencies are binned along
+    enum binning_id {
+      BY_MULTIPLICITY    = 0, //!< Number of simulated gammas
+      BY_ENERGY          = 1, //!< Total energy of the reconstructed gammas
+      BY_CALOS           = 2, //!< Number of calibrated calorimeters
+      NUMBER_OF_BINNINGS = 3
+    };
+
+    /// Return the name of a binning
+    static const char * get_binning_name(binning_id binning_);
 
     /// Constructor
     snemo_gamma_tracking_efficiency_module(datatools::logger::priority = datatools::logger::PRIO_FATAL);
@@ -87,67 +127,211 @@ namespace analysis {
     /// Reset
     virtual void reset();
 
+    /// Legacy recursive cluster exploration, only used to cross-check the clustering engine
     void get_new_neighbours(geomtools::geom_id gid,
                             const snemo::datamodel::calibrated_data::calorimeter_hit_collection_type & cch,
                             std::vector<geomtools::geom_id>  & ccl,
                             std::vector<geomtools::geom_id>  & a_cluster);
-    ///*,                                                             std::vector<geomtools::geom_id> new_calib_neighbours*/);
 
-    /// Data record processing
+    /// Data record processing (may be called concurrently from several threads)
     virtual process_status process(datatools::things & data_);
 
+    /// Process a set of data records with the configured number of worker threads,
+    /// waiting for the 'process' and 'process_batch' calls of other threads to end
+    void process_records(const std::vector<datatools::things *> & records_,
+                         std::vector<process_status> & statuses_);
+
+    /// Process consecutive data records on the calling thread, all of them being decoded before being analysed
+    void process_batch(datatools::things * const * records_,
+                       size_t nrecords_,
+                       process_status * statuses_);
+
   protected:
 
+    /// Per thread processing state
+    struct shard_type;
+
     /// Give default values to specific class members.
     void _set_defaults();
 
-    /// Identify the calorimeter blocks clusters from the 'particle_track_data' bank
-    void _pre_process_clustering(const datatools::things & data_,
-                                 gamma_dict_type & gammas_);
+    /// Create a new processing state
+    shard_type & _add_shard();
+
+    /// Return the processing state of the current thread
+    shard_type & _grab_shard();
+
+    /// Return the processing state of a 'process_records' worker thread given its rank
+    shard_type & _grab_worker_shard(size_t ithread_);
+
+    /// Merge the worker threads processing states into the module ones
+    void _merge_shards();
+
+    /// Process a data record given its rank in the input
+    process_status _process_record(datatools::things & data_, uint64_t record_);
+
+    /// Process consecutive data records given the rank of the first one in the input
+    void _process_batch(datatools::things * const * records_,
+                        size_t nrecords_,
+                        uint64_t first_record_,
+                        process_status * statuses_,
+                        shard_type & shard_);
+
+    /// Decode a data record, return false if the pre-filter rejects it
+    bool _extract_record(const datatools::things & data_,
+                         gamma_event_view & event_,
+                         shard_type & shard_);
+
+    /// Analyse a decoded event (only its outcome is recorded if it has been rejected)
+    process_status _analyse_event(const gamma_event_view & event_,
+                                  bool accepted_,
+                                  shard_type & shard_);
+
+    /// Store a checkpoint if one is due (processing states must not be in use when 'quiescent_' is set)
+    void _update_checkpoint(bool quiescent_);
+
+    /// Merge the processing states and store them in the checkpoint file
+    void _store_checkpoint();
+
+    /// Add an event outcome to the processing state block, written when full
+    void _record_outcome(const event_outcome_store::row_type & outcome_,
+                         shard_type & shard_);
+
+    /// Store the calorimeter hit table of an event for replay
+    void _store_hit_table(const gamma_event_view & event_,
+                          shard_type & shard_);
+
+    /// Export counters and histograms (processing states must have been merged)
+    void _export_run_state(run_state & state_) const;
+
+    /// Identify the calorimeter blocks clusters from the 'particle_track_data' bank,
+    /// one sequences dictionnary per clustering time gap (the configured one first)
+    void _pre_process_clustering(const gamma_event_view & event_,
+                                 gamma_dict_type * gammas_,
+                                 shard_type & shard_);
 
     /// Get gammas sequence from 'simulated_data' bank
-    dpp::base_module::process_status _process_simulated_gammas(const datatools::things & data_,
-                                                               gamma_dict_type & gammas_);
+    dpp::base_module::process_status _process_simulated_gammas(const gamma_event_view & event_,
+                                                               gamma_dict_type & gammas_,
+                                                               shard_type & shard_);
 
     /// Get gammas sequence from 'particle_track_data' bank
-    dpp::base_module::process_status _process_reconstructed_gammas(const datatools::things & data_,
-                                                                   gamma_dict_type & gammas_);
+    dpp::base_module::process_status _process_reconstructed_gammas(const gamma_event_view & event_,
+                                                                   gamma_dict_type & gammas_,
+                                                                   shard_type & shard_);
+
+    /// Compare simulated and reconstructed gamma track lengths
+    dpp::base_module::process_status _compute_gamma_track_length(const gamma_event_view & event_,
+                                                                 shard_type & shard_);
+
+    /// Report calorimeter hits without channel, only the first time some are found
+    void _report_unknown_channels(size_t nunknown_);
 
-    /// Compare simulated and reconstructed gamma track length
-    dpp::base_module::process_status _compute_gamma_track_length(const datatools::things & data_);
+    /// Check clustering engine output against the legacy recursive exploration
+    void _check_clustering(const gamma_event_view & event_,
+                           const shard_type & shard_);
 
     /// Compare 2 sequences of calorimeters
     bool _compare_sequences(const gamma_dict_type & simulated_gammas_,
-                            const gamma_dict_type & reconstructed_gammas_);
+                            const gamma_dict_type & reconstructed_gammas_,
+                            shard_type & shard_);
 
     /// Compare 2 sequences of calorimeters for gamma clustering only
     bool _compare_sequences_cluster(const gamma_dict_type & simulated_gammas_,
-                            const gamma_dict_type & clustered_gammas_);
+                                    const gamma_dict_type & clustered_gammas_,
+                                    shard_type & shard_);
+
+    /// Tally (and histogram) the kinds of differences of compared sequences
+    void _account_for_kinds(const gamma_sequence_matcher::match_type & match_,
+                            bool clustered_,
+                            shard_type & shard_);
+
+    /// Account for a compared event in the binned efficiencies
+    void _fill_binned_efficiencies(const event_outcome_store::row_type & outcome_,
+                                   shard_type & shard_);
+
+    /// Compare simulated sequences with the clustered ones of each scanned time gap
+    void _compare_sequences_scan(const gamma_dict_type & simulated_gammas_,
+                                 const gamma_dict_type * clustered_gammas_,
+                                 shard_type & shard_);
 
   private:
 
     // The key fields from 'event header' bank to build the histogram key:
     std::vector<std::string> _key_fields_;
 
+    // Categories of the simulated calorimeter step hits holding the truth
+    std::vector<std::string> _step_hit_categories_;
+
     // The histogram pool :
     mygsl::histogram_pool * _histogram_pool_;
 
-    // Locator plugin
+    // Copy of the histogram templates for worker threads :
+    std::unique_ptr<mygsl::histogram_pool> _template_pool_;
+
+    // Locator plugin (null when the calorimeter channels come from the geometry cache)
     const snemo::geometry::locator_plugin * _locator_plugin_;
 
+    // Calorimeter channels numbering
+    calorimeter_channel_index _channels_;
+
+    // Calorimeter first neighbours table
+    calorimeter_adjacency _adjacency_;
+
+    // Calorimeter hits without channel have been reported
+    std::atomic<bool> _unknown_channels_reported_;
+
+    // Build connected components of calorimeters
+    bool _transitive_clustering_;
+
+    // Cross-check clustering with the legacy recursive exploration
+    bool _check_clustering_;
+
+    // Time gap splitting clusters (ns)
+    double _time_gap_;
+
+    // Time gaps scanned in addition (ns)
+    std::vector<double> _time_gap_scan_;
+
+    // Time gaps given to the clustering, the configured one first
+    std::vector<double> _clustering_gaps_;
+
+    // Number of worker threads used by 'process_records'
+    size_t _number_of_threads_;
+
+    // Number of records decoded before being analysed by 'process_records'
+    size_t _batch_size_;
+
+    // Processing time of the analysis stages, summed over threads
+    stage_timing _timing_;
+
+    // Histogram the stage latencies
+    bool _timing_histograms_;
+
+    // Checkpointing
+    std::string _checkpoint_file_;    //!< Checkpoint file (none if empty)
+    uint64_t _checkpoint_events_;     //!< Number of event records between checkpoints (0 if unused)
+    double _checkpoint_seconds_;      //!< Time between checkpoints (0 if unused)
+    uint64_t _last_checkpoint_record_; //!< Number of event records at the last checkpoint
+    std::chrono::steady_clock::time_point _last_checkpoint_time_; //!< Time of the last checkpoint
+    bool _checkpoint_warned_;         //!< Concurrent 'process' calls have been reported
+
+    // Per event outcomes file
+    event_outcome_store _outcomes_;
+
+    // Calorimeter hit tables file for replay
+    hit_table _hit_tables_;
+
+    // Run state file written at reset (none if empty)
+    std::string _run_state_file_;
+
+    // Number of event records given to the module
+    std::atomic<uint64_t> _number_of_records_;
+
+    // Number of event records already processed by the resumed job, skipped
+    uint64_t _number_of_resumed_records_;
+
     /// Internal structure to compute efficiency
-    struct efficiency_type {
-      size_t nevent; //!< Total number of event processed
-      size_t ntotal; //!< Total number of gammas simulated
-      size_t ngamma; //!< Number of gammas simulated for each event
-      size_t ngood;  //!< Number of gammas well reconstructed
-      size_t nmiss;  //!< Number of gammas that do not trigger detector
-      size_t ngood_event;  //!< Number of events fully and successfully reconstructed
-      size_t nevent_gammas;  //!< Number of events with at least one gamma
-
-      size_t no_gt_ngood_event;  //!< Number of events fully and successfully reconstructed
-      size_t no_gt_nevent_gammas;  //!< Number of events with at least one gamma
-    };
+    typedef gamma_efficiency efficiency_type;
 
     /// Efficiency structure
     efficiency_type _efficiency_;
@@ -155,10 +339,74 @@ namespace analysis {
     /// No GT efficiency structure
     efficiency_type _no_gt_efficiency_;
 
+    /// No GT efficiency structures of the scanned time gaps
+    std::vector<efficiency_type> _time_gap_scan_efficiency_;
+
+    /// Efficiencies binned along event variables
+    binned_efficiency _binned_efficiency_[NUMBER_OF_BINNINGS];
+
+    /// No GT efficiencies binned along event variables
+    binned_efficiency _no_gt_binned_efficiency_[NUMBER_OF_BINNINGS];
+
+    /// Confidence level of the binned efficiency intervals
+    double _confidence_level_;
+
+    /// Counters and log sampling of the sequence mismatches
+    mismatch_report _mismatches_;
+
+    /// Histogram the kinds of sequence differences
+    bool _mismatch_histograms_;
+
+    /// Cheap checks rejecting events before their hits are decoded
+    event_prefilter _prefilter_;
+
+    /// Compare the simulated and reconstructed gamma track lengths
+    bool _track_length_;
+
+    // Per thread processing states, the first one fills the module histogram pool :
+    std::vector<std::unique_ptr<shard_type> > _shards_;
+    std::map<std::thread::id, shard_type *> _thread_shards_;
+    std::mutex _shards_mutex_;
+    // 'process_records' workers reuse the states of the calling threads, they never run along with them :
+    std::shared_timed_mutex _entry_mutex_;
+
     // Macro to automate the registration of the module :
     DPP_MODULE_REGISTRATION_INTERFACE(snemo_gamma_tracking_efficiency_module);
   };
 
+  /// Per thread processing state
+  struct snemo_gamma_tracking_efficiency_module::shard_type
+  {
+    efficiency_type efficiency;       //!< Efficiency counters
+    efficiency_type no_gt_efficiency; //!< No GT efficiency counters
+    std::vector<efficiency_type> time_gap_scan; //!< No GT efficiency counters of the scanned time gaps
+    binned_efficiency binned[NUMBER_OF_BINNINGS];       //!< Binned efficiencies
+    binned_efficiency no_gt_binned[NUMBER_OF_BINNINGS]; //!< Binned no GT efficiencies
+
+    std::unique_ptr<mygsl::histogram_pool> pool; //!< Private histogram pool (worker threads only)
+    histogram_registry histograms;               //!< Histogram handles
+
+    event_arena arena;                 //!< Memory of the event containers
+    gamma_event_view event;            //!< Decoded event
+    gamma_sequence_builder sequences;  //!< Sequences building
+    gamma_sequence_matcher matcher;    //!< Sequence matching
+    stage_timing timing;               //!< Stage processing time
+    int32_t run_number;                //!< Run number of the event being processed (-1 if unknown)
+    int32_t event_number;              //!< Event number of the event being processed (-1 if unknown)
+    event_outcome_store::block_type outcomes; //!< Event outcomes not written yet
+    mygsl::histogram_1d * mismatch_kinds[2];  //!< Kinds of sequence differences with and without gamma tracking (if histogrammed)
+    hit_table::event_type hits;               //!< Calorimeter hit table of the event
+
+    // Working space, kept from one event to the other:
+    std::vector<size_t>       gap_clusters;     //!< Number of clusters per time gap
+    std::vector<int>          channel_truths;   //!< First primary track id per channel (hit tables)
+    std::vector<channel_type> touched_channels; //!< Channels with a track id to be cleaned
+    std::vector<std::unique_ptr<gamma_event_view> > batch_events; //!< Decoded events of a batch
+    path_length               simulated_path;     //!< Simulated step segments (track length)
+    path_length               reconstructed_path; //!< Reconstructed vertex segments (track length)
+    std::vector<bool>         batch_accepted;   //!< Events of a batch accepted by the pre-filter
+  };
+
 } // namespace analysis
 
 #endif // ANALYSIS_SNEMO_GAMMA_TRACKING_EFFICIENCY_MODULE_H_
@@ -0,0 +1,117 @@
+// snemo_gt_eff_merge.cc
+//
+// Merge the run state files written by gamma tracking efficiency jobs
+// ('run_state.file' or 'checkpoint.file' module properties) run on parts
+// of a sample, and print the global efficiencies computed from the summed
+// raw counters. Inputs are read one after the other so that the memory
+// used does not depend on their number.
+//
+// Usage: snemo_gt_eff_merge [--output FILE] FILE...
+
+// Standard library:
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <stdexcept>
+
+// This project:
+#include <run_state.h>
+#include <gamma_efficiency.h>
+
+int main(int argc_, char ** argv_)
+{
+  std::string output_file;
+  std::vector<std::string> the_input_files;
+
+  try {
+    for (int iarg = 1; iarg < argc_; iarg++) {
+      const std::string an_option = argv_[iarg];
+      if (an_option == "--help" || an_option == "-h") {
+        std::cout << "Usage: " << argv_[0] << " [--output FILE] FILE..." << std::endl;
+        return 0;
+      }
+      if (an_option == "--output" || an_option == "-o") {
+        if (iarg + 1 >= argc_) throw std::invalid_argument("Missing value for option '" + an_option + "'");
+        output_file = argv_[++iarg];
+        continue;
+      }
+      if (an_option.compare(0, 1, "-") == 0) throw std::invalid_argument("Unknown option '" + an_option + "'");
+      the_input_files.push_back(an_option);
+    }
+    if (the_input_files.empty()) throw std::invalid_argument("No run state file to merge");
+
+    analysis::run_state the_merged_state;
+    analysis::run_state a_state;
+    for (const auto & ifile : the_input_files) {
+      a_state.load(ifile);
+      the_merged_state.merge(a_state);
+    }
+
+    // Binned efficiency counters are named '<kind>.<variable>.<binning>.<bin>.passed|total':
+    // inputs binned differently end up under distinct names and cannot be combined
+    const std::vector<std::string> the_binned_prefixes = {"binned_efficiency.", "no_gt_binned_efficiency."};
+    std::map<std::string, std::string> the_binnings;
+    for (const auto & icounter : the_merged_state.get_counters()) {
+      const std::string & a_name = icounter.first;
+      for (const auto & a_binned_prefix : the_binned_prefixes) {
+        if (a_name.compare(0, a_binned_prefix.size(), a_binned_prefix) != 0) continue;
+        const size_t a_variable_end = a_name.find('.', a_binned_prefix.size());
+        const size_t a_bin_start = a_name.rfind('.', a_name.rfind('.') - 1);
+        if (a_variable_end == std::string::npos || a_bin_start <= a_variable_end) continue;
+        const std::string a_variable = a_name.substr(0, a_variable_end + 1);
+        const std::string a_binning = a_name.substr(a_variable_end + 1, a_bin_start - a_variable_end - 1);
+        const auto a_found = the_binnings.insert(std::make_pair(a_variable, a_binning)).first;
+        if (a_found->second != a_binning) {
+          throw std::logic_error("Binned efficiency '" + a_variable + "' stored with different binnings ('"
+                                 + a_found->second + "' and '" + a_binning + "')");
+        }
+      }
+    }
+
+    std::cout << "Number of run state files = " << the_input_files.size() << std::endl;
+    std::cout << "Number of event records = " << the_merged_state.get_number_of_processed_events() << std::endl;
+    analysis::gamma_efficiency an_efficiency = {};
+    analysis::gamma_efficiency a_no_gt_efficiency = {};
+    an_efficiency.import_counters(the_merged_state, "efficiency.");
+    a_no_gt_efficiency.import_counters(the_merged_state, "no_gt_efficiency.");
+    analysis::gamma_efficiency::print(std::cout, an_efficiency, a_no_gt_efficiency);
+
+    // Efficiency versus clustering time gap ('clustering.time_gap_scan')
+    const std::string a_scan_prefix = "time_gap_scan.";
+    const std::string a_scan_suffix = "ns.no_gt_nevent_gammas";
+    std::map<double, std::string> the_scanned_gaps;
+    for (const auto & icounter : the_merged_state.get_counters()) {
+      const std::string & a_name = icounter.first;
+      if (a_name.compare(0, a_scan_prefix.size(), a_scan_prefix) != 0) continue;
+      if (a_name.size() < a_scan_prefix.size() + a_scan_suffix.size()
+          || a_name.compare(a_name.size() - a_scan_suffix.size(), a_scan_suffix.size(), a_scan_suffix) != 0) continue;
+      const std::string a_gap = a_name.substr(a_scan_prefix.size(),
+                                              a_name.size() - a_scan_prefix.size() - a_scan_suffix.size());
+      the_scanned_gaps[std::stod(a_gap)] = a_scan_prefix + a_gap + "ns.";
+    }
+    for (const auto & igap : the_scanned_gaps) {
+      analysis::gamma_efficiency a_scan_efficiency = {};
+      a_scan_efficiency.import_counters(the_merged_state, igap.second);
+      const size_t ngood = a_scan_efficiency.no_gt_ngood_event;
+      const size_t ntotal = a_scan_efficiency.no_gt_nevent_gammas;
+      std::cout << "Time gap " << igap.first << " ns : number of events with gammas successfully clustered = "
+                << ngood << " / " << ntotal << " ( " << ngood/(double)ntotal*100 << " %)" << std::endl;
+    }
+
+    if (! output_file.empty()) the_merged_state.store(output_file);
+  } catch (std::exception & error_) {
+    std::cerr << "error: " << error_.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// end of snemo_gt_eff_merge.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
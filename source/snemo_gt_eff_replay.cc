@@ -0,0 +1,168 @@
+// snemo_gt_eff_replay.cc
+//
+// Compute again the gamma tracking efficiencies from the calorimeter hit
+// tables stored by the module ('hits.file' property), without the data
+// processing pipeline. Sequences are built and compared with the same code
+// as the module, so that replaying with the module settings gives the same
+// efficiencies; the clustering settings may be changed to study their
+// effect on a whole sample in seconds.
+//
+// Usage: snemo_gt_eff_replay [--time-gap NS] [--transitive] [--output FILE] FILE...
+
+// Standard library:
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+// This project:
+#include <hit_table.h>
+#include <gamma_sequence_builder.h>
+#include <gamma_sequence_matcher.h>
+#include <gamma_efficiency.h>
+#include <event_arena.h>
+#include <run_state.h>
+
+namespace {
+
+  typedef analysis::gamma_sequence_builder::gamma_dict_type gamma_dict_type;
+
+  /// Replay settings
+  struct settings_type {
+    double time_gap;         //!< Time gap splitting clusters (ns)
+    bool transitive;         //!< Build connected components of calorimeters
+  };
+
+  /// Replay the hit tables of a file
+  void replay(const std::string & filename_,
+              const settings_type & settings_,
+              analysis::gamma_efficiency & efficiency_,
+              analysis::gamma_efficiency & no_gt_efficiency_,
+              uint64_t & nevents_)
+  {
+    analysis::hit_table a_file;
+    a_file.open(filename_);
+    const analysis::hit_table::neighbourhood_type & a_neighbourhood = a_file.get_neighbourhood();
+
+    analysis::gamma_sequence_builder a_builder;
+    a_builder.initialize(a_neighbourhood.offsets.size() - 1,
+                         a_neighbourhood.offsets.data(),
+                         a_neighbourhood.neighbours.data(),
+                         settings_.transitive);
+    a_builder.set_time_gap(settings_.time_gap);
+    analysis::gamma_sequence_matcher a_matcher;
+    analysis::event_arena an_arena;
+    analysis::hit_table::event_type an_event;
+
+    while (a_file.read(an_event)) {
+      nevents_++;
+      an_arena.release();
+      analysis::event_arena::scope an_arena_scope(an_arena);
+
+      // Same stages and stops as the module
+      if (! (an_event.flags & analysis::hit_table::HAS_PARTICLE_TRACK_DATA)) {
+        throw std::logic_error("Missing particle track data in an event of '" + filename_ + "'");
+      }
+      gamma_dict_type clustered_gammas;
+      a_builder.build_clustered(an_event.channels.data(), an_event.times.data(),
+                                an_event.number_of_gamma_hits, clustered_gammas);
+
+      if (! (an_event.flags & analysis::hit_table::HAS_SIMULATED_DATA)) continue;
+      if (! (an_event.flags & analysis::hit_table::HAS_CALIBRATED_DATA)) continue;
+      if (! (an_event.flags & analysis::hit_table::HAS_STEP_HITS)) continue;
+      if (an_event.number_of_calibrated_hits == 0 || an_event.number_of_step_hits == 0) continue;
+
+      // Rows hold the first primary track id of their channel, that is the
+      // only step hit the simulated sequences depend on (calibrated hits
+      // with unknown channels only make no sequence)
+      gamma_dict_type simulated_gammas;
+      size_t nattributed = 0;
+      if (an_event.size() > 0 &&
+          a_builder.build_simulated(an_event.channels.data(), an_event.size(),
+                                    an_event.channels.data(), an_event.truth_track_ids.data(), an_event.size(),
+                                    an_event.number_of_primary_gammas, simulated_gammas, nattributed)
+          != analysis::gamma_sequence_builder::SIMULATED_OK) continue;
+
+      if (an_event.gamma_track_ids.empty()) continue;
+      gamma_dict_type reconstructed_gammas;
+      a_builder.build_reconstructed(an_event.channels.data(), an_event.hit_gammas.data(),
+                                    an_event.gamma_track_ids.data(), an_event.number_of_gamma_hits,
+                                    reconstructed_gammas);
+
+      efficiency_.add_comparison(simulated_gammas.size(), reconstructed_gammas.size(),
+                                 a_matcher.count_identical(simulated_gammas, reconstructed_gammas));
+      no_gt_efficiency_.add_cluster_comparison(simulated_gammas.size(), clustered_gammas.size(),
+                                               a_matcher.count_identical(simulated_gammas, clustered_gammas));
+    }
+    return;
+  }
+
+}
+
+int main(int argc_, char ** argv_)
+{
+  settings_type the_settings;
+  the_settings.time_gap = analysis::gamma_sequence_builder::DEFAULT_TIME_GAP;
+  the_settings.transitive = false;
+  std::string output_file;
+  std::vector<std::string> the_input_files;
+
+  try {
+    for (int iarg = 1; iarg < argc_; iarg++) {
+      const std::string an_option = argv_[iarg];
+      if (an_option == "--help" || an_option == "-h") {
+        std::cout << "Usage: " << argv_[0] << " [--time-gap NS] [--transitive] [--output FILE] FILE..." << std::endl;
+        return 0;
+      }
+      if (an_option == "--time-gap" || an_option == "-t") {
+        if (iarg + 1 >= argc_) throw std::invalid_argument("Missing value for option '" + an_option + "'");
+        the_settings.time_gap = std::stod(argv_[++iarg]);
+        continue;
+      }
+      if (an_option == "--transitive") {
+        the_settings.transitive = true;
+        continue;
+      }
+      if (an_option == "--output" || an_option == "-o") {
+        if (iarg + 1 >= argc_) throw std::invalid_argument("Missing value for option '" + an_option + "'");
+        output_file = argv_[++iarg];
+        continue;
+      }
+      if (an_option.compare(0, 1, "-") == 0) throw std::invalid_argument("Unknown option '" + an_option + "'");
+      the_input_files.push_back(an_option);
+    }
+    if (the_input_files.empty()) throw std::invalid_argument("No hit table file to replay");
+
+    analysis::gamma_efficiency an_efficiency = {};
+    analysis::gamma_efficiency a_no_gt_efficiency = {};
+    uint64_t nevents = 0;
+    for (const auto & ifile : the_input_files) {
+      replay(ifile, the_settings, an_efficiency, a_no_gt_efficiency, nevents);
+    }
+
+    std::cout << "Number of hit table files = " << the_input_files.size() << std::endl;
+    std::cout << "Number of event records = " << nevents << std::endl;
+    analysis::gamma_efficiency::print(std::cout, an_efficiency, a_no_gt_efficiency);
+
+    if (! output_file.empty()) {
+      analysis::run_state a_state;
+      a_state.set_number_of_processed_events(nevents);
+      an_efficiency.export_counters(a_state, "efficiency.");
+      a_no_gt_efficiency.export_counters(a_state, "no_gt_efficiency.");
+      a_state.store(output_file);
+    }
+  } catch (std::exception & error_) {
+    std::cerr << "error: " << error_.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// end of snemo_gt_eff_replay.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
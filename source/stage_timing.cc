@@ -0,0 +1,168 @@
+// stage_timing.cc
+
+// Ourselves:
+#include <stage_timing.h>
+
+// Standard library:
+#include <cmath>
+
+// Third party:
+// - Bayeux/mygsl
+#include <mygsl/histogram_pool.h>
+
+namespace analysis {
+
+  namespace {
+
+    const char * STAGE_NAMES[stage_timing::NUMBER_OF_STAGES] = {
+      "extraction",
+      "clustering",
+      "simulated",
+      "reconstructed",
+      "comparison",
+      "track_length",
+      "event"
+    };
+
+  }
+
+  const size_t stage_timing::NUMBER_OF_BUCKETS;
+
+  const char * stage_timing::get_stage_name(stage_id stage_)
+  {
+    return STAGE_NAMES[stage_];
+  }
+
+  stage_timing::scope::scope(stage_timing & timing_, stage_id stage_)
+  {
+    _timing_ = timing_.is_enabled() ? &timing_ : 0;
+    _stage_ = stage_;
+    if (_timing_) _start_ = std::chrono::steady_clock::now();
+    return;
+  }
+
+  stage_timing::scope::~scope()
+  {
+    if (! _timing_) return;
+    const std::chrono::steady_clock::duration a_duration = std::chrono::steady_clock::now() - _start_;
+    _timing_->add(_stage_, std::chrono::duration_cast<std::chrono::nanoseconds>(a_duration).count());
+    return;
+  }
+
+  stage_timing::stage_timing()
+  {
+    _enabled_ = false;
+    for (size_t i = 0; i < NUMBER_OF_STAGES; i++) _histograms_[i] = 0;
+    clear();
+    return;
+  }
+
+  bool stage_timing::is_enabled() const
+  {
+    return _enabled_;
+  }
+
+  void stage_timing::set_enabled(bool enabled_)
+  {
+    _enabled_ = enabled_;
+    return;
+  }
+
+  void stage_timing::set_histogram_pool(mygsl::histogram_pool & pool_)
+  {
+    for (size_t i = 0; i < NUMBER_OF_STAGES; i++) {
+      const std::string a_name = std::string(STAGE_NAMES[i]) + "_latency";
+      if (! pool_.has(a_name)) {
+        // log10 of the duration in ns, from 10 ns to 10 s
+        pool_.add_1d(a_name, "", "timing").initialize(160, 1., 10.);
+      }
+      _histograms_[i] = &pool_.grab_1d(a_name);
+    }
+    return;
+  }
+
+  void stage_timing::clear()
+  {
+    for (size_t i = 0; i < NUMBER_OF_STAGES; i++) {
+      _calls_[i] = 0;
+      _totals_[i] = 0;
+      for (size_t j = 0; j < NUMBER_OF_BUCKETS; j++) _buckets_[i][j] = 0;
+    }
+    return;
+  }
+
+  void stage_timing::add(stage_id stage_, uint64_t duration_)
+  {
+    _calls_[stage_]++;
+    _totals_[stage_] += duration_;
+    _buckets_[stage_][_bucket_(duration_)]++;
+    if (_histograms_[stage_]) _histograms_[stage_]->fill(std::log10(duration_ + 1.));
+    return;
+  }
+
+  void stage_timing::merge(const stage_timing & other_)
+  {
+    for (size_t i = 0; i < NUMBER_OF_STAGES; i++) {
+      _calls_[i] += other_._calls_[i];
+      _totals_[i] += other_._totals_[i];
+      for (size_t j = 0; j < NUMBER_OF_BUCKETS; j++) _buckets_[i][j] += other_._buckets_[i][j];
+    }
+    return;
+  }
+
+  size_t stage_timing::get_number_of_calls(stage_id stage_) const
+  {
+    return _calls_[stage_];
+  }
+
+  double stage_timing::get_total(stage_id stage_) const
+  {
+    return _totals_[stage_];
+  }
+
+  double stage_timing::get_mean(stage_id stage_) const
+  {
+    if (_calls_[stage_] == 0) return 0.;
+    return _totals_[stage_] / (double) _calls_[stage_];
+  }
+
+  double stage_timing::get_percentile(stage_id stage_, double percentile_) const
+  {
+    if (_calls_[stage_] == 0) return 0.;
+    const double a_rank = percentile_ / 100. * _calls_[stage_];
+    uint64_t a_count = 0;
+    for (size_t j = 0; j < NUMBER_OF_BUCKETS; j++) {
+      a_count += _buckets_[stage_][j];
+      if (a_count >= a_rank && a_count > 0) return _bucket_edge_(j);
+    }
+    return _bucket_edge_(NUMBER_OF_BUCKETS - 1);
+  }
+
+  size_t stage_timing::_bucket_(uint64_t duration_)
+  {
+    // Durations below 16 ns have their own bucket, larger ones are split in
+    // 8 buckets per power of 2
+    if (duration_ < 16) return duration_;
+    const size_t an_exponent = 63 - __builtin_clzll(duration_);
+    const size_t a_sub_bucket = (duration_ >> (an_exponent - 3)) & 0x7;
+    return 16 + (an_exponent - 4) * 8 + a_sub_bucket;
+  }
+
+  double stage_timing::_bucket_edge_(size_t bucket_)
+  {
+    if (bucket_ < 16) return bucket_ + 1;
+    const size_t an_exponent = 4 + (bucket_ - 16) / 8;
+    const size_t a_sub_bucket = (bucket_ - 16) % 8;
+    return std::ldexp(8. + a_sub_bucket + 1., an_exponent - 3);
+  }
+
+} // namespace analysis
+
+// end of stage_timing.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,151 @@
+/* stage_timing.h
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Processing time of the analysis stages of the gamma tracking efficiency
+ * module, measured with the steady clock by scoped timers. Durations are
+ * accumulated in logarithmic buckets (8 buckets per power of 2) so that
+ * percentiles are estimated with a bounded memory and that the timings
+ * of several threads can be merged. Latencies may also be histogrammed
+ * (log10 of the duration in ns) in a histogram pool.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_STAGE_TIMING_H_
+#define ANALYSIS_STAGE_TIMING_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+namespace mygsl {
+  class histogram_1d;
+  class histogram_pool;
+}
+
+namespace analysis {
+
+  class stage_timing
+  {
+  public:
+
+    /// Analysis stages
+    enum stage_id {
+      EXTRACTION     = 0,
+      CLUSTERING     = 1,
+      SIMULATED      = 2,
+      RECONSTRUCTED  = 3,
+      COMPARISON     = 4,
+      TRACK_LENGTH   = 5,
+      EVENT          = 6,
+      NUMBER_OF_STAGES = 7
+    };
+
+    /// Number of duration buckets
+    static const size_t NUMBER_OF_BUCKETS = 16 + 60 * 8;
+
+    /// Return the name of a stage
+    static const char * get_stage_name(stage_id stage_);
+
+    /// Time a stage for the scope lifetime, nothing is done if timing is disabled
+    class scope
+    {
+    public:
+
+      /// Constructor
+      scope(stage_timing & timing_, stage_id stage_);
+
+      /// Destructor
+      ~scope();
+
+    private:
+
+      stage_timing * _timing_;  //!< Timing to fill (null if disabled)
+      stage_id _stage_;          //!< Timed stage
+      std::chrono::steady_clock::time_point _start_; //!< Start time
+    };
+
+    /// Constructor
+    stage_timing();
+
+    /// Check if timing is enabled
+    bool is_enabled() const;
+
+    /// Enable/disable timing
+    void set_enabled(bool enabled_);
+
+    /// Histogram the latencies in a pool
+    void set_histogram_pool(mygsl::histogram_pool & pool_);
+
+    /// Clear the accumulated durations
+    void clear();
+
+    /// Add a stage duration in ns
+    void add(stage_id stage_, uint64_t duration_);
+
+    /// Add the durations of another timing
+    void merge(const stage_timing & other_);
+
+    /// Return the number of timed calls of a stage
+    size_t get_number_of_calls(stage_id stage_) const;
+
+    /// Return the total duration of a stage in ns
+    double get_total(stage_id stage_) const;
+
+    /// Return the mean duration of a stage in ns
+    double get_mean(stage_id stage_) const;
+
+    /// Return an estimate of a duration percentile of a stage in ns
+    double get_percentile(stage_id stage_, double percentile_) const;
+
+  private:
+
+    /// Return the bucket of a duration
+    static size_t _bucket_(uint64_t duration_);
+
+    /// Return the upper edge of a bucket
+    static double _bucket_edge_(size_t bucket_);
+
+    bool _enabled_; //!< Timing flag
+
+    uint64_t _calls_[NUMBER_OF_STAGES];   //!< Number of timed calls
+    uint64_t _totals_[NUMBER_OF_STAGES];  //!< Total durations
+    uint32_t _buckets_[NUMBER_OF_STAGES][NUMBER_OF_BUCKETS]; //!< Duration buckets
+
+    mygsl::histogram_1d * _histograms_[NUMBER_OF_STAGES]; //!< Latency histograms
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_STAGE_TIMING_H_
+
+// end of stage_timing.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,319 @@
+// test_clustering_equivalence.cc
+//
+// Check that the clustered gamma sequences built by the sequence builder
+// (iterative clustering engine, flat time ordering) are identical to the
+// ones of the former recursive 'get_new_neighbours' exploration followed by
+// the time ordered cluster maps, on the gamma hits of calorimeter hit
+// tables ('hits.file' property of the module). The former code is
+// transcribed below on channel numbers; a hit without channel stands for a
+// block of its own.
+//
+// The former code keyed the hits of a cluster by their time, thus lost
+// hits sharing a time within a cluster: such events are not compared.
+//
+// Usage: test_clustering_equivalence FILE...
+//        test_clustering_equivalence --generate FILE
+//
+// The second form writes the synthetic hit tables used as test fixture
+// (two 20 x 13 calorimeter walls with their 8 first neighbours).
+
+// Standard library:
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+// This project:
+#include <hit_table.h>
+#include <gamma_sequence_builder.h>
+#include <event_arena.h>
+
+namespace {
+
+  typedef analysis::gamma_sequence_builder::gamma_dict_type gamma_dict_type;
+  typedef std::map<int, std::set<uint32_t> > legacy_dict_type;
+
+  /// Time gaps compared, the module default one first
+  const double TIME_GAPS[] = {analysis::gamma_sequence_builder::DEFAULT_TIME_GAP, 0.5, 10.0};
+  const size_t NUMBER_OF_TIME_GAPS = sizeof(TIME_GAPS) / sizeof(TIME_GAPS[0]);
+
+  /// Former calorimeter clustering, transcribed on block numbers
+  class legacy_clustering
+  {
+  public:
+
+    legacy_clustering(const analysis::hit_table::neighbourhood_type & neighbourhood_)
+      : _neighbourhood_(neighbourhood_)
+    {
+      return;
+    }
+
+    /// Build the clustered sequences and return the number of clusters
+    size_t build(const std::vector<uint32_t> & blocks_,
+                 const std::vector<double> & times_,
+                 double gap_,
+                 legacy_dict_type & clustered_gammas_,
+                 bool & lossy_) const
+    {
+      std::vector<uint32_t> ccl;
+      std::vector<std::vector<uint32_t> > the_clusters;
+      for (const auto iblock : blocks_) {
+        std::vector<uint32_t> a_cluster(1, iblock);
+        if (std::find(ccl.begin(), ccl.end(), iblock) != ccl.end()) continue;
+        _get_new_neighbours(iblock, blocks_, ccl, a_cluster);
+        the_clusters.push_back(a_cluster);
+      }
+      size_t number_of_clusters = the_clusters.size();
+
+      lossy_ = false;
+      std::vector<std::map<double, uint32_t> > the_ordered_clusters;
+      for (const auto & icluster : the_clusters) {
+        std::map<double, uint32_t> a_cluster;
+        size_t nhits = 0;
+        for (const auto iblock : icluster) {
+          for (size_t ihit = 0; ihit < blocks_.size(); ihit++) {
+            if (blocks_[ihit] != iblock) continue;
+            a_cluster.insert(std::make_pair(times_[ihit], iblock));
+            nhits++;
+          }
+        }
+        if (a_cluster.size() != nhits) lossy_ = true;
+        the_ordered_clusters.push_back(a_cluster);
+      }
+      std::sort(the_ordered_clusters.begin(), the_ordered_clusters.end());
+
+      int track_id = 0;
+      for (const auto & icluster : the_ordered_clusters) {
+        track_id++;
+        double t0 = 0;
+        double t1 = 0;
+        for (const auto & ipair : icluster) {
+          t0 = t1;
+          t1 = ipair.first;
+          if (t0 != 0 && t1 != 0 && t1 - t0 > gap_) {
+            number_of_clusters++;
+            track_id++;
+          }
+          clustered_gammas_[track_id].insert(ipair.second);
+        }
+      }
+      return number_of_clusters;
+    }
+
+  private:
+
+    void _get_new_neighbours(uint32_t block_,
+                             const std::vector<uint32_t> & blocks_,
+                             std::vector<uint32_t> & ccl_,
+                             std::vector<uint32_t> & a_cluster_) const
+    {
+      if (std::find(ccl_.begin(), ccl_.end(), block_) != ccl_.end()) return;
+      ccl_.push_back(block_);
+
+      // Blocks without channel have no neighbour
+      const size_t nchannels = _neighbourhood_.offsets.size() - 1;
+      if (block_ >= nchannels) return;
+
+      std::vector<uint32_t> the_calib_neighbours;
+      for (uint32_t i = _neighbourhood_.offsets[block_]; i < _neighbourhood_.offsets[block_ + 1]; i++) {
+        const uint32_t a_neighbour = _neighbourhood_.neighbours[i];
+        if (std::find(blocks_.begin(), blocks_.end(), a_neighbour) == blocks_.end()) continue;
+        if (std::find(ccl_.begin(), ccl_.end(), a_neighbour) != ccl_.end()) continue;
+        the_calib_neighbours.push_back(a_neighbour);
+        ccl_.push_back(a_neighbour);
+        a_cluster_.push_back(a_neighbour);
+      }
+      for (const auto ineighbour : the_calib_neighbours) _get_new_neighbours(ineighbour, blocks_, ccl_, a_cluster_);
+      return;
+    }
+
+    const analysis::hit_table::neighbourhood_type & _neighbourhood_; //!< Calorimeter neighbourhood
+  };
+
+  /// Compare the sequences of the builder with the former ones (blocks without channel have empty lists)
+  bool same_sequences(const gamma_dict_type & gammas_,
+                      const legacy_dict_type & legacy_gammas_,
+                      size_t nchannels_)
+  {
+    if (gammas_.size() != legacy_gammas_.size()) return false;
+    auto ilegacy = legacy_gammas_.begin();
+    for (const auto & igamma : gammas_) {
+      if (igamma.first != ilegacy->first) return false;
+      std::set<uint32_t> the_channels;
+      for (const auto ichannel : ilegacy->second) {
+        if (ichannel < nchannels_) the_channels.insert(ichannel);
+      }
+      if (! std::equal(igamma.second.begin(), igamma.second.end(), the_channels.begin(), the_channels.end())) return false;
+      ilegacy++;
+    }
+    return true;
+  }
+
+  /// Compare the clustered sequences of the events of a file, return the number of failures
+  size_t check(const std::string & filename_, uint64_t & ncompared_, uint64_t & nskipped_)
+  {
+    analysis::hit_table a_file;
+    a_file.open(filename_);
+    const analysis::hit_table::neighbourhood_type & a_neighbourhood = a_file.get_neighbourhood();
+    const size_t nchannels = a_neighbourhood.offsets.size() - 1;
+
+    analysis::gamma_sequence_builder a_builder;
+    a_builder.initialize(nchannels, a_neighbourhood.offsets.data(), a_neighbourhood.neighbours.data(), false);
+    const legacy_clustering a_legacy(a_neighbourhood);
+    analysis::event_arena an_arena;
+    analysis::hit_table::event_type an_event;
+
+    size_t nfailures = 0;
+    std::vector<uint32_t> the_blocks;
+    std::vector<double> the_times;
+    while (a_file.read(an_event)) {
+      an_arena.release();
+      analysis::event_arena::scope an_arena_scope(an_arena);
+
+      // Every hit without channel is a block of its own
+      const size_t nhits = an_event.number_of_gamma_hits;
+      the_blocks.clear();
+      the_times.assign(an_event.times.begin(), an_event.times.begin() + nhits);
+      for (size_t ihit = 0; ihit < nhits; ihit++) {
+        const uint32_t a_channel = an_event.channels[ihit];
+        the_blocks.push_back(a_channel < nchannels ? a_channel : nchannels + ihit);
+      }
+
+      std::vector<gamma_dict_type> the_gammas(NUMBER_OF_TIME_GAPS);
+      std::vector<size_t> the_nclusters(NUMBER_OF_TIME_GAPS);
+      a_builder.build_clustered(an_event.channels.data(), an_event.times.data(), nhits,
+                                TIME_GAPS, NUMBER_OF_TIME_GAPS, the_gammas.data(), the_nclusters.data());
+
+      for (size_t igap = 0; igap < NUMBER_OF_TIME_GAPS; igap++) {
+        legacy_dict_type the_legacy_gammas;
+        bool lossy = false;
+        const size_t a_legacy_nclusters = a_legacy.build(the_blocks, the_times, TIME_GAPS[igap], the_legacy_gammas, lossy);
+        if (lossy) {
+          nskipped_++;
+          break;
+        }
+        ncompared_++;
+        if (the_nclusters[igap] == a_legacy_nclusters
+            && same_sequences(the_gammas[igap], the_legacy_gammas, nchannels)) continue;
+        nfailures++;
+        std::cerr << "error: event #" << a_file.get_number_of_events() << " (run " << an_event.run_number
+                  << ", event " << an_event.event_number << ") of '" << filename_ << "' differs with a "
+                  << TIME_GAPS[igap] << " ns time gap : " << the_nclusters[igap] << " vs. "
+                  << a_legacy_nclusters << " clusters" << std::endl;
+      }
+    }
+    return nfailures;
+  }
+
+  /// Write the synthetic test fixture
+  void generate(const std::string & filename_)
+  {
+    const uint32_t NSIDES = 2;
+    const uint32_t NCOLUMNS = 20;
+    const uint32_t NROWS = 13;
+    const uint32_t NEVENTS = 400;
+
+    analysis::hit_table::neighbourhood_type a_neighbourhood;
+    a_neighbourhood.offsets.push_back(0);
+    for (uint32_t iside = 0; iside < NSIDES; iside++) {
+      for (uint32_t icolumn = 0; icolumn < NCOLUMNS; icolumn++) {
+        for (uint32_t irow = 0; irow < NROWS; irow++) {
+          for (int dcolumn = -1; dcolumn <= 1; dcolumn++) {
+            for (int drow = -1; drow <= 1; drow++) {
+              const int a_column = icolumn + dcolumn;
+              const int a_row = irow + drow;
+              if (dcolumn == 0 && drow == 0) continue;
+              if (a_column < 0 || a_column >= (int) NCOLUMNS || a_row < 0 || a_row >= (int) NROWS) continue;
+              a_neighbourhood.neighbours.push_back((iside * NCOLUMNS + a_column) * NROWS + a_row);
+            }
+          }
+          a_neighbourhood.offsets.push_back(a_neighbourhood.neighbours.size());
+        }
+      }
+    }
+    const uint32_t nchannels = a_neighbourhood.offsets.size() - 1;
+
+    analysis::hit_table a_file;
+    a_file.create(filename_, a_neighbourhood);
+    std::mt19937 a_generator(20141227);
+    std::uniform_int_distribution<uint32_t> a_channel_distribution(0, nchannels - 1);
+    std::uniform_real_distribution<double> a_start_distribution(0.0, 20.0);
+    std::uniform_real_distribution<double> a_delay_distribution(0.1, 6.0);
+    std::uniform_real_distribution<double> a_probability(0.0, 1.0);
+
+    analysis::hit_table::event_type an_event;
+    for (uint32_t ievent = 0; ievent < NEVENTS; ievent++) {
+      an_event.clear();
+      an_event.run_number = 0;
+      an_event.event_number = ievent;
+      an_event.flags = analysis::hit_table::HAS_PARTICLE_TRACK_DATA;
+      const uint32_t ngammas = 1 + a_generator() % 3;
+      for (uint32_t igamma = 0; igamma < ngammas; igamma++) {
+        an_event.gamma_track_ids.push_back(igamma + 2);
+        // Gammas walk to neighbouring blocks, now and then to any block
+        uint32_t a_channel = a_channel_distribution(a_generator);
+        double a_time = a_start_distribution(a_generator);
+        const uint32_t nhits = 1 + a_generator() % 4;
+        for (uint32_t ihit = 0; ihit < nhits; ihit++) {
+          if (a_probability(a_generator) < 0.05) {
+            an_event.push_back(analysis::calorimeter_channel_index::INVALID_CHANNEL, igamma, 0, a_time, 1.0);
+          } else {
+            an_event.push_back(a_channel, igamma, 0, a_time, 1.0);
+          }
+          a_time += a_delay_distribution(a_generator);
+          const uint32_t nneighbours = a_neighbourhood.offsets[a_channel + 1] - a_neighbourhood.offsets[a_channel];
+          if (a_probability(a_generator) < 0.8) {
+            a_channel = a_neighbourhood.neighbours[a_neighbourhood.offsets[a_channel] + a_generator() % nneighbours];
+          } else {
+            a_channel = a_channel_distribution(a_generator);
+          }
+        }
+      }
+      an_event.number_of_gamma_hits = an_event.size();
+      an_event.number_of_calibrated_hits = an_event.size();
+      a_file.write(an_event);
+    }
+    a_file.close();
+    return;
+  }
+
+}
+
+int main(int argc_, char ** argv_)
+{
+  try {
+    if (argc_ == 3 && std::string(argv_[1]) == "--generate") {
+      generate(argv_[2]);
+      return 0;
+    }
+    if (argc_ < 2) throw std::invalid_argument("No hit table file to check");
+
+    size_t nfailures = 0;
+    uint64_t ncompared = 0;
+    uint64_t nskipped = 0;
+    for (int iarg = 1; iarg < argc_; iarg++) {
+      nfailures += check(argv_[iarg], ncompared, nskipped);
+    }
+    std::cout << "Number of compared clusterings = " << ncompared << std::endl;
+    std::cout << "Number of events with hits sharing a time = " << nskipped << std::endl;
+    std::cout << "Number of differences = " << nfailures << std::endl;
+    if (ncompared == 0) throw std::logic_error("No event has been compared");
+    return nfailures == 0 ? 0 : 1;
+  } catch (std::exception & error_) {
+    std::cerr << "error: " << error_.what() << std::endl;
+    return 1;
+  }
+}
+
+// end of test_clustering_equivalence.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
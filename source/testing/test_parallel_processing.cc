@@ -0,0 +1,306 @@
+// test_parallel_processing.cc
+//
+// Check that the module gives the same efficiency counters and histogram
+// contents whatever the number of 'process_records' worker threads. The
+// same synthetic event records (simulated, calibrated and particle track
+// data on two 8 x 5 calorimeter walls) are processed by a single thread,
+// then by several ones. Each job starts with a few 'process' calls on the
+// calling thread, and another thread calls 'process' while the records are
+// processed by 'process_records'; the run states stored at reset are
+// compared.
+//
+// Usage: test_parallel_processing [NTHREADS]
+
+// Standard library:
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <memory>
+#include <random>
+#include <algorithm>
+#include <thread>
+#include <cstdlib>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/things.h>
+#include <datatools/properties.h>
+#include <datatools/service_manager.h>
+#include <datatools/clhep_units.h>
+// - Bayeux/mygsl:
+#include <mygsl/histogram_pool.h>
+// - Bayeux/mctools:
+#include <mctools/simulated_data.h>
+#include <mctools/utils.h>
+// - Falaise:
+#include <snemo/datamodels/data_model.h>
+#include <snemo/datamodels/calibrated_data.h>
+#include <snemo/datamodels/particle_track.h>
+#include <snemo/datamodels/particle_track_data.h>
+
+// This project:
+#include <snemo_gamma_tracking_efficiency_module.h>
+#include <geometry_cache.h>
+#include <run_state.h>
+
+namespace {
+
+  const uint32_t CALORIMETER_TYPE = 1302;
+  const uint32_t NSIDES = 2;
+  const uint32_t NCOLUMNS = 8;
+  const uint32_t NROWS = 5;
+  const size_t NRECORDS = 4000;
+  const size_t NSINGLE_RECORDS = 50;
+  const size_t NRECORDS_PER_CALL = 2000;
+  const char * SETUP_LABEL = "test_parallel_processing";
+  const char * SETUP_VERSION = "1.0";
+
+  geomtools::geom_id block_gid(uint32_t side_, uint32_t column_, uint32_t row_)
+  {
+    geomtools::geom_id a_gid;
+    a_gid.set_type(CALORIMETER_TYPE);
+    a_gid.set_depth(4);
+    a_gid.set(0, 0);
+    a_gid.set(1, side_);
+    a_gid.set(2, column_);
+    a_gid.set(3, row_);
+    return a_gid;
+  }
+
+  /// Write the geometry cache of the calorimeter walls, blocks having their 8 first neighbours
+  void store_geometry(const std::string & filename_, std::vector<geomtools::geom_id> & gids_)
+  {
+    std::vector<uint32_t> the_offsets(1, 0);
+    std::vector<analysis::calorimeter_adjacency::channel_type> the_neighbours;
+    for (uint32_t iside = 0; iside < NSIDES; iside++) {
+      for (uint32_t icolumn = 0; icolumn < NCOLUMNS; icolumn++) {
+        for (uint32_t irow = 0; irow < NROWS; irow++) {
+          gids_.push_back(block_gid(iside, icolumn, irow));
+          for (int dcolumn = -1; dcolumn <= 1; dcolumn++) {
+            for (int drow = -1; drow <= 1; drow++) {
+              const int a_column = icolumn + dcolumn;
+              const int a_row = irow + drow;
+              if (dcolumn == 0 && drow == 0) continue;
+              if (a_column < 0 || a_column >= (int) NCOLUMNS || a_row < 0 || a_row >= (int) NROWS) continue;
+              the_neighbours.push_back((iside * NCOLUMNS + a_column) * NROWS + a_row);
+            }
+          }
+          the_offsets.push_back(the_neighbours.size());
+        }
+      }
+    }
+    analysis::calorimeter_channel_index the_channels;
+    analysis::calorimeter_adjacency an_adjacency;
+    the_channels.initialize(gids_);
+    an_adjacency.initialize(the_offsets, the_neighbours);
+    analysis::geometry_cache a_cache;
+    a_cache.set_setup(SETUP_LABEL, SETUP_VERSION);
+    a_cache.store(filename_, the_channels, an_adjacency);
+    return;
+  }
+
+  /// Build event records where gammas walk along neighbouring blocks; now
+  /// and then the reconstruction merges two gammas or misses a hit
+  void generate_records(const std::vector<geomtools::geom_id> & gids_,
+                        std::vector<std::unique_ptr<datatools::things> > & records_)
+  {
+    namespace sdm = snemo::datamodel;
+    std::mt19937 a_generator(20141227);
+    std::uniform_real_distribution<double> a_probability(0.0, 1.0);
+    for (size_t irecord = 0; irecord < NRECORDS; irecord++) {
+      records_.emplace_back(new datatools::things);
+      datatools::things & a_record = *records_.back();
+      mctools::simulated_data & a_sd
+        = a_record.add<mctools::simulated_data>(sdm::data_info::default_simulated_data_label());
+      sdm::calibrated_data & a_cd
+        = a_record.add<sdm::calibrated_data>(sdm::data_info::default_calibrated_data_label());
+      sdm::particle_track_data & a_ptd
+        = a_record.add<sdm::particle_track_data>(sdm::data_info::default_particle_track_data_label());
+      const std::string & a_category = analysis::gamma_event_view::default_step_hit_category();
+      a_sd.add_step_hits(a_category);
+
+      std::set<size_t> the_blocks;
+      const int ngammas = 1 + a_generator() % 3;
+      double a_time = 0.0;
+      int nparticles = 0;
+      sdm::particle_track::handle_type a_particle;
+      for (int igamma = 0; igamma < ngammas; igamma++) {
+        genbb::primary_particle a_gamma;
+        a_gamma.set_type(genbb::primary_particle::GAMMA);
+        a_gamma.set_kinetic_energy(1.0 * CLHEP::MeV);
+        a_sd.grab_primary_event().add_particle(a_gamma);
+
+        // Merged gammas make a single reconstructed particle
+        if (! a_particle.has_data() || a_probability(a_generator) > 0.1) {
+          a_particle.reset(new sdm::particle_track);
+          a_particle.grab().set_track_id(nparticles++);
+          a_particle.grab().set_charge(sdm::particle_track::NEUTRAL);
+          a_ptd.add_particle(a_particle);
+        }
+        size_t a_block = a_generator() % gids_.size();
+        const int nhits = 1 + a_generator() % 4;
+        for (int ihit = 0; ihit < nhits; ihit++) {
+          a_time += 0.5 + 5.0 * a_probability(a_generator);
+          if (the_blocks.insert(a_block).second) {
+            mctools::base_step_hit & a_step_hit = a_sd.add_step_hit(a_category);
+            a_step_hit.set_hit_id(ihit);
+            a_step_hit.set_geom_id(gids_[a_block]);
+            a_step_hit.grab_auxiliaries().store_integer(mctools::track_utils::TRACK_ID_KEY, igamma + 1);
+
+            sdm::calibrated_data::calorimeter_hit_handle_type a_hit(new sdm::calibrated_calorimeter_hit);
+            a_hit.grab().set_hit_id(a_cd.calibrated_calorimeter_hits().size());
+            a_hit.grab().set_geom_id(gids_[a_block]);
+            a_hit.grab().set_time(a_time);
+            a_hit.grab().set_energy(0.2 + a_probability(a_generator));
+            a_cd.calibrated_calorimeter_hits().push_back(a_hit);
+            if (a_probability(a_generator) > 0.05) {
+              a_particle.grab().grab_associated_calorimeter_hits().push_back(a_hit);
+            }
+          }
+          // Next block along the same wall
+          const uint32_t a_side = a_block / (NCOLUMNS * NROWS);
+          const int a_column = (a_block / NROWS) % NCOLUMNS + (int) (a_generator() % 3) - 1;
+          const int a_row = a_block % NROWS + (int) (a_generator() % 3) - 1;
+          if (a_column < 0 || a_column >= (int) NCOLUMNS || a_row < 0 || a_row >= (int) NROWS) break;
+          a_block = (a_side * NCOLUMNS + a_column) * NROWS + a_row;
+        }
+      }
+    }
+    return;
+  }
+
+  /// Process the records and return the run state stored at reset
+  void run(const std::string & geometry_file_,
+           size_t nthreads_,
+           const std::vector<std::unique_ptr<datatools::things> > & records_,
+           analysis::run_state & state_)
+  {
+    const std::string a_state_file = "test_parallel_processing_" + std::to_string(nthreads_) + ".state";
+    datatools::properties a_config;
+    a_config.store_string("geometry_cache.file", geometry_file_);
+    a_config.store_string("geometry_cache.setup_label", SETUP_LABEL);
+    a_config.store_string("geometry_cache.setup_version", SETUP_VERSION);
+    a_config.store_integer("processing.threads", static_cast<int>(nthreads_));
+    a_config.store_integer("processing.batch_size", 3);
+    a_config.store_boolean("mismatch.histograms", true);
+    a_config.store_string("run_state.file", a_state_file);
+
+    mygsl::histogram_pool a_pool;
+    a_pool.initialize(datatools::properties());
+    a_pool.add_1d("number_of_calos_template", "", "template").initialize(20, 0.0, 20.0);
+    a_pool.add_1d("energy_template", "", "template").initialize(40, 0.0, 10.0);
+
+    datatools::service_manager a_service_manager;
+    dpp::module_handle_dict_type a_module_dict;
+    analysis::snemo_gamma_tracking_efficiency_module a_module;
+    a_module.set_histogram_pool(a_pool);
+    a_module.initialize(a_config, a_service_manager, a_module_dict);
+
+    // The calling thread state is then reused by the first worker
+    for (size_t irecord = 0; irecord < NSINGLE_RECORDS; irecord++) {
+      a_module.process(*records_[irecord]);
+    }
+    // Another thread calls 'process' along with the 'process_records' calls
+    std::thread a_thread([&] () {
+        for (size_t irecord = NSINGLE_RECORDS; irecord < 2 * NSINGLE_RECORDS; irecord++) {
+          a_module.process(*records_[irecord]);
+        }
+      });
+    std::vector<dpp::base_module::process_status> the_statuses;
+    for (size_t irecord = 2 * NSINGLE_RECORDS; irecord < records_.size(); irecord += NRECORDS_PER_CALL) {
+      std::vector<datatools::things *> the_records;
+      for (size_t i = irecord; i < std::min(irecord + NRECORDS_PER_CALL, records_.size()); i++) {
+        the_records.push_back(records_[i].get());
+      }
+      a_module.process_records(the_records, the_statuses);
+    }
+    a_thread.join();
+    a_module.reset();
+    state_.load(a_state_file);
+    return;
+  }
+
+  /// Count the differences of two run states
+  size_t compare(const analysis::run_state & expected_, const analysis::run_state & state_)
+  {
+    size_t ndifferences = 0;
+    if (expected_.get_number_of_processed_events() != state_.get_number_of_processed_events()) {
+      std::cerr << "error: " << state_.get_number_of_processed_events() << " processed event records instead of "
+                << expected_.get_number_of_processed_events() << std::endl;
+      ndifferences++;
+    }
+    if (expected_.get_counters() != state_.get_counters()) {
+      for (const auto & icounter : expected_.get_counters()) {
+        if (state_.has_counter(icounter.first) && state_.get_counter(icounter.first) == icounter.second) continue;
+        std::cerr << "error: counter '" << icounter.first << "' differs" << std::endl;
+        ndifferences++;
+      }
+      if (expected_.get_counters().size() != state_.get_counters().size()) {
+        std::cerr << "error: " << state_.get_counters().size() << " counters instead of "
+                  << expected_.get_counters().size() << std::endl;
+        ndifferences++;
+      }
+    }
+    if (expected_.get_histograms().size() != state_.get_histograms().size()) {
+      std::cerr << "error: " << state_.get_histograms().size() << " histograms instead of "
+                << expected_.get_histograms().size() << std::endl;
+      return ndifferences + 1;
+    }
+    for (size_t ihisto = 0; ihisto < expected_.get_histograms().size(); ihisto++) {
+      const analysis::run_state::histogram_type & an_expected = expected_.get_histograms()[ihisto];
+      const analysis::run_state::histogram_type & a_histo = state_.get_histograms()[ihisto];
+      if (an_expected.name == a_histo.name
+          && an_expected.min == a_histo.min
+          && an_expected.max == a_histo.max
+          && an_expected.underflow == a_histo.underflow
+          && an_expected.overflow == a_histo.overflow
+          && an_expected.contents == a_histo.contents) continue;
+      std::cerr << "error: histogram '" << an_expected.name << "' differs" << std::endl;
+      ndifferences++;
+    }
+    return ndifferences;
+  }
+
+}
+
+int main(int argc_, char ** argv_)
+{
+  try {
+    const size_t nthreads = argc_ > 1 ? std::atoi(argv_[1]) : 4;
+    if (nthreads < 2) throw std::invalid_argument("At least 2 threads are needed");
+
+    const std::string a_geometry_file = "test_parallel_processing.geom";
+    std::vector<geomtools::geom_id> the_gids;
+    store_geometry(a_geometry_file, the_gids);
+    std::vector<std::unique_ptr<datatools::things> > the_records;
+    generate_records(the_gids, the_records);
+
+    analysis::run_state a_single_state;
+    analysis::run_state a_parallel_state;
+    run(a_geometry_file, 1, the_records, a_single_state);
+    run(a_geometry_file, nthreads, the_records, a_parallel_state);
+    if (! a_single_state.has_counter("efficiency.nevent") || a_single_state.get_counter("efficiency.nevent") == 0) {
+      throw std::logic_error("No event has been compared");
+    }
+
+    const size_t ndifferences = compare(a_single_state, a_parallel_state);
+    std::cout << "Number of event records = " << a_single_state.get_number_of_processed_events() << std::endl;
+    std::cout << "Number of compared events = " << a_single_state.get_counter("efficiency.nevent") << std::endl;
+    std::cout << "Number of differences with " << nthreads << " threads = " << ndifferences << std::endl;
+    return ndifferences == 0 ? 0 : 1;
+  } catch (std::exception & error_) {
+    std::cerr << "error: " << error_.what() << std::endl;
+    return 1;
+  }
+}
+
+// end of test_parallel_processing.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/